@@ -0,0 +1,69 @@
+#include "DeepLeafMask.h"
+
+#include <cstring>
+
+#include "world/level/tile/Tile.h"
+
+DeepLeafMask::DeepLeafMask()
+{
+	memset(bits, 0, sizeof(bits));
+	valid = false;
+}
+
+bool DeepLeafMask::isLeaf(TileID blockId)
+{
+	Tile* tile = Tile::tiles[blockId];
+	return tile && (tile == Tile::leaves || tile == Tile::leaves2);
+}
+
+void DeepLeafMask::build(TileSource& region, const TilePos& origin)
+{
+	memset(bits, 0, sizeof(bits));
+	for(int y = 0; y < 16; y++)
+	{
+		for(int z = 0; z < 16; z++)
+		{
+			for(int x = 0; x < 16; x++)
+			{
+				TilePos pos(origin.x + x, origin.y + y, origin.z + z);
+				if(!isLeaf(region.getTile(pos.x, pos.y, pos.z).blockId))
+				{
+					continue;
+				}
+				if(LeafTile::isDeepLeafTile(region, pos))
+				{
+					int index = _index(x, y, z);
+					bits[index >> 6] |= (uint64_t) 1 << (index & 63);
+				}
+			}
+		}
+	}
+
+	valid = true;
+}
+
+void DeepLeafMask::ensureBuilt(TileSource& region, const TilePos& origin)
+{
+	if(!valid)
+	{
+		build(region, origin);
+	}
+}
+
+bool DeepLeafMask::onTileChanged(int x, int y, int z, TileID oldId, TileID newId)
+{
+	if(!isLeaf(oldId) && !isLeaf(newId))
+	{
+		return false;
+	}
+
+	/* a leaf is deep only when surrounded by leaves, so non-leaf changes can't flip a bit
+		but a leaf change can flip every bit around it
+	*/
+	valid = false;
+
+	x &= 15;
+	y &= 15;
+	z &= 15;
+	return x == 0 || x == 15 || y == 0 || y == 15 || z == 0 || z == 15;
+}
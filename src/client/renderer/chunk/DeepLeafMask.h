@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+/* One bit per tile of a 16x16x16 section, set for leaves buried inside their canopy
+	Computed once with LeafTile::isDeepLeafTile and kept until a leaf in or next to
+	the section changes, so leaf face culling during meshing is a bit test.
+*/
+class DeepLeafMask
+{
+public:
+	DeepLeafMask();
+
+	bool isValid() const { return valid; }
+	void invalidate() { valid = false; }
+
+	/* origin is the section corner, a multiple of 16 */
+	void build(TileSource&, const TilePos&);
+	/* Rebuilds only when invalidated since the last build */
+	void ensureBuilt(TileSource&, const TilePos&);
+
+	bool isDeep(int x, int y, int z) const
+	{
+		int index = _index(x & 15, y & 15, z & 15);
+		return (bits[index >> 6] >> (index & 63)) & 1;
+	}
+
+	/* Called by the owner when a tile of the section changes
+		Returns true if the change touched leaves on the section border,
+		in which case the neighbouring section's mask must be invalidated as well
+	*/
+	bool onTileChanged(int, int, int, TileID, TileID);
+
+	static bool isLeaf(TileID);
+
+private:
+	uint64_t bits[64];
+	bool valid;
+
+	static int _index(int x, int y, int z)
+	{
+		return (y << 8) | (z << 4) | x;
+	}
+};
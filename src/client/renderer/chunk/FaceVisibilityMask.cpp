@@ -0,0 +1,82 @@
+#include "FaceVisibilityMask.h"
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+
+void FaceVisibilityMask::gather(TileSource& region, const TilePos& origin, TileID* ids)
+{
+	for(int y = 0; y < PADDED; y++)
+	{
+		for(int z = 0; z < PADDED; z++)
+		{
+			TileID* row = ids + gatherIndex(0, y, z);
+			for(int x = 0; x < PADDED; x++)
+			{
+				row[x] = region.getTile(origin.x + x - 1, origin.y + y - 1, origin.z + z - 1).blockId;
+			}
+		}
+	}
+}
+
+void FaceVisibilityMask::build(TileSource& region, const TilePos& origin)
+{
+	TileID ids[PADDED_VOLUME];
+	gather(region, origin, ids);
+	build(ids);
+}
+
+void FaceVisibilityMask::build(const TileID* ids)
+{
+	/* occupancy bitplanes, bit x of [y][z] is set when the padded tile is solid */
+	uint32_t occupied[PADDED][PADDED];
+	for(int y = 0; y < PADDED; y++)
+	{
+		for(int z = 0; z < PADDED; z++)
+		{
+			occupied[y][z] = TileProperties::gather(ids + gatherIndex(0, y, z), PADDED, TileProperties::SOLID);
+		}
+	}
+
+	/* every face is the inverted neighbour row, 16 tiles per AND */
+	for(int y = 0; y < SIZE; y++)
+	{
+		const uint32_t* below = occupied[y];
+		const uint32_t* level = occupied[y + 1];
+		const uint32_t* above = occupied[y + 2];
+		for(int z = 0; z < SIZE; z++)
+		{
+			faces[0][y][z] = (uint16_t) (~below[z + 1] >> 1);
+			faces[1][y][z] = (uint16_t) (~above[z + 1] >> 1);
+			faces[2][y][z] = (uint16_t) (~level[z] >> 1);
+			faces[3][y][z] = (uint16_t) (~level[z + 2] >> 1);
+			faces[4][y][z] = (uint16_t) ~level[z + 1];
+			faces[5][y][z] = (uint16_t) (~level[z + 1] >> 2);
+		}
+	}
+}
+
+bool FaceVisibilityMask::isFullyHidden() const
+{
+	const uint16_t* row = &faces[0][0][0];
+	uint16_t any = 0;
+	for(int i = 0; i < 6 * SIZE * SIZE; i++)
+	{
+		any |= row[i];
+	}
+
+	return any == 0;
+}
+
+int FaceVisibilityMask::countVisible() const
+{
+	const uint16_t* row = &faces[0][0][0];
+	int count = 0;
+	for(int i = 0; i < 6 * SIZE * SIZE; i++)
+	{
+		for(uint16_t bits = row[i]; bits; bits &= bits - 1)
+		{
+			count++;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+/* Face visibility for a 16x16x16 section, computed in one pass instead of
+	one TileSource::isSolidRenderTile call per face.
+	Block IDs are gathered once with a one block border, mapped through the
+	packed solid[] table into occupancy rows (bit x of the (y, z) row) and
+	each face mask is the row of the neighbour in that direction, inverted.
+*/
+class FaceVisibilityMask
+{
+public:
+	static const int SIZE = 16;
+	static const int PADDED = SIZE + 2;
+	static const int PADDED_VOLUME = PADDED * PADDED * PADDED;
+
+	/* [face][y][z], bit x set when the face of (x, y, z) is not covered by a solid tile */
+	uint16_t faces[6][SIZE][SIZE];
+
+	/* Reads the section at origin (multiple of 16) plus its border out of the region */
+	void build(TileSource&, const TilePos&);
+	/* ids is PADDED_VOLUME entries indexed by gatherIndex(), border included */
+	void build(const TileID*);
+
+	bool isVisible(int x, int y, int z, FacingID face) const
+	{
+		return (faces[face][y][z] >> x) & 1;
+	}
+
+	uint16_t getRow(FacingID face, int y, int z) const
+	{
+		return faces[face][y][z];
+	}
+
+	/* True if no face of the section can be seen, the mesher can skip it entirely */
+	bool isFullyHidden() const;
+	int countVisible() const;
+
+	static int gatherIndex(int x, int y, int z)
+	{
+		return (y * PADDED + z) * PADDED + x;
+	}
+
+	/* Fills ids with the padded section, coordinates are relative to origin - 1 */
+	static void gather(TileSource&, const TilePos&, TileID*);
+};
@@ -0,0 +1,260 @@
+#include "GreedyMesher.h"
+
+#include <cstring>
+
+#include "FaceVisibilityMask.h"
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileStateTable.h"
+
+bool GreedyMesher::enabled = false;
+std::atomic<uint64_t> GreedyMesher::totalFacesIn(0);
+std::atomic<uint64_t> GreedyMesher::totalQuadsOut(0);
+
+static const int FACE_OFFSET[6][3] = {{0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}};
+
+void GreedyMesher::setEnabled(bool _enabled)
+{
+	enabled = _enabled;
+}
+
+bool GreedyMesher::isEnabled()
+{
+	return enabled;
+}
+
+GreedyMesher::Stats GreedyMesher::getTotalStats()
+{
+	Stats stats;
+	stats.facesIn = totalFacesIn.load(std::memory_order_relaxed);
+	stats.quadsOut = totalQuadsOut.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void GreedyMesher::resetTotalStats()
+{
+	totalFacesIn.store(0, std::memory_order_relaxed);
+	totalQuadsOut.store(0, std::memory_order_relaxed);
+}
+
+bool GreedyMesher::canMerge(const Tile* tile, DataID data, FacingID face)
+{
+	return _canMerge(*TileStateTable::acquire(), tile, data, face);
+}
+
+/* Only plain opaque cubes whose texture doesn't care about orientation can be repeated, checked per data value (wool colours, log axes) */
+bool GreedyMesher::_canMerge(const TileStateTable::Snapshot& states, const Tile* tile, DataID data, FacingID face)
+{
+	if(!tile)
+	{
+		return false;
+	}
+
+	const TileStateTable::State& state = states.get(tile->blockId, data);
+	return state.renderLayer == Tile::RENDERLAYER_OPAQUE &&
+		state.renderShape == 0 &&
+		Tile::solid[tile->blockId] &&
+		tile->isTextureIsotropic(face);
+}
+
+/* Maps (slice, u, v) of a face plane back to section-local x, y, z */
+void GreedyMesher::_toLocal(FacingID face, int slice, int u, int v, int& x, int& y, int& z)
+{
+	switch(face)
+	{
+	case 0:
+	case 1:
+		x = u; y = slice; z = v;
+		break;
+	case 2:
+	case 3:
+		x = u; y = v; z = slice;
+		break;
+	default:
+		x = slice; y = v; z = u;
+		break;
+	}
+}
+
+uint16_t GreedyMesher::_intern(const CellKey& key)
+{
+	for(size_t i = 0; i < keys.size(); i++)
+	{
+		if(keys[i].texture == key.texture && keys[i].color == key.color && keys[i].light == key.light)
+		{
+			return i + 1;
+		}
+	}
+
+	keys.push_back(key);
+	return keys.size();
+}
+
+GreedyMesher::Stats GreedyMesher::build(TileSource& region, const TilePos& origin, const TileID* ids, const FaceVisibilityMask& mask, std::vector<Quad>& out)
+{
+	Stats stats = Stats();
+	memset(handled, 0, sizeof(handled));
+
+	/* one table for the whole section, the atlas may be swapped meanwhile */
+	TileStateTable::Ref states = TileStateTable::acquire();
+	for(int face = 0; face < 6; face++)
+	{
+		for(int slice = 0; slice < 16; slice++)
+		{
+			keys.clear();
+			int faces = 0;
+			for(int v = 0; v < 16; v++)
+			{
+				for(int u = 0; u < 16; u++)
+				{
+					int x, y, z;
+					_toLocal(face, slice, u, v, x, y, z);
+					cells[v][u] = 0;
+
+					if(!mask.isVisible(x, y, z, face))
+					{
+						continue;
+					}
+
+					Tile* tile = Tile::tiles[ids[FaceVisibilityMask::gatherIndex(x + 1, y + 1, z + 1)]];
+					int wx = origin.x + x, wy = origin.y + y, wz = origin.z + z;
+					DataID data = tile? region.getData(wx, wy, wz) : 0;
+					if(!_canMerge(*states, tile, data, face))
+					{
+						continue;
+					}
+
+					CellKey key;
+					if(states->isPositionDependent(tile->blockId, data))
+					{
+						key.texture = &tile->getTexture(&region, wx, wy, wz, face);
+						key.color = tile->getColor(&region, wx, wy, wz);
+					}
+					else
+					{
+						key.texture = &states->getUV(tile->blockId, data, face);
+						key.color = states->getColor(tile->blockId, data);
+					}
+					TilePos front(wx + FACE_OFFSET[face][0], wy + FACE_OFFSET[face][1], wz + FACE_OFFSET[face][2]);
+					key.light = (uint8_t) (((region.getBrightness(LightLayer::Sky, front) & 15) << 4) | (region.getBrightness(LightLayer::Block, front) & 15));
+					cells[v][u] = _intern(key);
+					handled[face][y][z] |= 1 << x;
+					faces++;
+				}
+			}
+
+			if(faces)
+			{
+				stats.facesIn += faces;
+				stats.quadsOut += _mergeSlice(face, slice, out);
+			}
+		}
+	}
+
+	totalFacesIn.fetch_add(stats.facesIn, std::memory_order_relaxed);
+	totalQuadsOut.fetch_add(stats.quadsOut, std::memory_order_relaxed);
+	return stats;
+}
+
+void GreedyMesher::getCorners(const Quad& quad, TessellationTemplateCache::Vertex corners[4])
+{
+	/* the merged area as one box, one tile thick across the face */
+	float size[3] = {1.0F, 1.0F, 1.0F};
+	switch(quad.face)
+	{
+	case 0:
+	case 1:
+		size[0] = quad.width;
+		size[2] = quad.height;
+		break;
+	case 2:
+	case 3:
+		size[0] = quad.width;
+		size[1] = quad.height;
+		break;
+	default:
+		size[2] = quad.width;
+		size[1] = quad.height;
+		break;
+	}
+
+	/* with the cell as big as the box, u and v run 0..width and 0..height like one tile's 0..1 */
+	AABB box(0.0F, 0.0F, 0.0F, size[0], size[1], size[2]);
+	TessellationTemplateCache::getFaceCorners(box, quad.face, Vec3(size[0], size[1], size[2]), corners);
+	for(int i = 0; i < 4; i++)
+	{
+		corners[i].x += quad.x;
+		corners[i].y += quad.y;
+		corners[i].z += quad.z;
+	}
+}
+
+/* Classic greedy sweep: grow along u, then along v while the whole run matches */
+int GreedyMesher::_mergeSlice(FacingID face, int slice, std::vector<Quad>& out)
+{
+	int quads = 0;
+	for(int v = 0; v < 16; v++)
+	{
+		for(int u = 0; u < 16;)
+		{
+			uint16_t key = cells[v][u];
+			if(!key)
+			{
+				u++;
+				continue;
+			}
+
+			int width = 1;
+			while(u + width < 16 && cells[v][u + width] == key)
+			{
+				width++;
+			}
+
+			int height = 1;
+			for(; v + height < 16; height++)
+			{
+				bool rowMatches = true;
+				for(int i = 0; i < width; i++)
+				{
+					if(cells[v + height][u + i] != key)
+					{
+						rowMatches = false;
+						break;
+					}
+				}
+				if(!rowMatches)
+				{
+					break;
+				}
+			}
+
+			for(int j = 0; j < height; j++)
+			{
+				for(int i = 0; i < width; i++)
+				{
+					cells[v + j][u + i] = 0;
+				}
+			}
+
+			const CellKey& cell = keys[key - 1];
+			int x, y, z;
+			_toLocal(face, slice, u, v, x, y, z);
+
+			Quad quad;
+			quad.face = face;
+			quad.x = x;
+			quad.y = y;
+			quad.z = z;
+			quad.width = width;
+			quad.height = height;
+			quad.light = cell.light;
+			quad.color = cell.color;
+			quad.texture = *cell.texture;
+			out.push_back(quad);
+
+			quads++;
+			u += width;
+		}
+	}
+
+	return quads;
+}
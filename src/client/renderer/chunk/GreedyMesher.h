@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "TessellationTemplateCache.h"
+
+class FaceVisibilityMask;
+
+/* Optional tessellation mode for opaque, isotropic full cubes (stone, dirt, sand...)
+	Visible coplanar faces sharing texture, light and tint are merged into one quad.
+	getCorners() gives the quad UVs counted in tiles, 0..width and 0..height, and the
+	shader wraps them into the quad's atlas rect with fract() so the texture repeats
+	w x h times instead of being stretched across the merged area. A renderer without
+	that wrap must leave the mode off.
+	Faces it takes are flagged in 'handled' so the regular per-face path skips them.
+*/
+class GreedyMesher
+{
+public:
+	struct Quad
+	{
+		FacingID face;
+		uint8_t x, y, z; // section-local corner of the first merged face
+		uint8_t width, height; // in tiles, along the u and v axis of the face
+		uint8_t light; // (sky << 4) | block, the raw light of the cells in front
+		int color;
+		TextureUVCoordinateSet texture; // a copy, the table it came from may be gone by the time the quad is drawn
+	};
+
+	struct Stats
+	{
+		uint64_t facesIn; // faces that would have been emitted one quad each
+		uint64_t quadsOut;
+
+		uint64_t getVerticesBefore() const { return facesIn * 4; }
+		uint64_t getVerticesAfter() const { return quadsOut * 4; }
+		float getReduction() const { return facesIn? 1.0F - (float) quadsOut / (float) facesIn : 0.0F; }
+	};
+
+	/* [face][y][z], bit x set when the greedy pass emitted that face */
+	uint16_t handled[6][16][16];
+
+	static void setEnabled(bool);
+	static bool isEnabled();
+	/* Summed over every build, mesher threads add to it concurrently */
+	static Stats getTotalStats();
+	static void resetTotalStats();
+
+	/* ids are the padded section from FaceVisibilityMask::gather */
+	Stats build(TileSource&, const TilePos&, const TileID*, const FaceVisibilityMask&, std::vector<Quad>&);
+
+	static bool canMerge(const Tile*, DataID, FacingID);
+	/* Section-local corners of a merged quad, uv in tiles as described above */
+	static void getCorners(const Quad&, TessellationTemplateCache::Vertex corners[4]);
+
+private:
+	struct CellKey
+	{
+		const TextureUVCoordinateSet* texture;
+		int color;
+		uint8_t light; // as in Quad, only faces with equal nibbles merge
+	};
+
+	static bool enabled;
+	static std::atomic<uint64_t> totalFacesIn, totalQuadsOut;
+
+	std::vector<CellKey> keys;
+	uint16_t cells[16][16];
+
+	static bool _canMerge(const TileStateTable::Snapshot&, const Tile*, DataID, FacingID);
+	uint16_t _intern(const CellKey&);
+	int _mergeSlice(FacingID, int, std::vector<Quad>&);
+	static void _toLocal(FacingID, int, int, int, int&, int&, int&);
+};
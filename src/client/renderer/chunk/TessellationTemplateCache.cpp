@@ -0,0 +1,190 @@
+#include "TessellationTemplateCache.h"
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileTextureTable.h"
+#include "world/level/tile/TileStateTable.h"
+
+/* Corners per face as (x, y, z) picks of the box, 0 for min and 1 for max, wound as the tessellator does */
+static const uint8_t FACE_CORNERS[6][4][3] = {
+	{{0, 0, 1}, {0, 0, 0}, {1, 0, 0}, {1, 0, 1}},
+	{{1, 1, 1}, {1, 1, 0}, {0, 1, 0}, {0, 1, 1}},
+	{{0, 1, 0}, {1, 1, 0}, {1, 0, 0}, {0, 0, 0}},
+	{{0, 1, 1}, {0, 0, 1}, {1, 0, 1}, {1, 1, 1}},
+	{{0, 1, 1}, {0, 1, 0}, {0, 0, 0}, {0, 0, 1}},
+	{{1, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}}
+};
+
+std::shared_ptr<const TessellationTemplateCache::Snapshot> TessellationTemplateCache::current = std::make_shared<TessellationTemplateCache::Snapshot>();
+
+float TessellationTemplateCache::_lerp(float from, float to, float t)
+{
+	return from + (to - from) * t;
+}
+
+void TessellationTemplateCache::getFaceCorners(const AABB& box, FacingID face, const Vec3& cell, Vertex corners[4])
+{
+	const float pick[2][3] = {{box.min.x, box.min.y, box.min.z}, {box.max.x, box.max.y, box.max.z}};
+
+	for(int i = 0; i < 4; i++)
+	{
+		Vertex& vertex = corners[i];
+		vertex.x = pick[FACE_CORNERS[face][i][0]][0];
+		vertex.y = pick[FACE_CORNERS[face][i][1]][1];
+		vertex.z = pick[FACE_CORNERS[face][i][2]][2];
+
+		/* the part of the texture the box covers, sides have v running down */
+		switch(face)
+		{
+		case 0:
+		case 1:
+			vertex.u = vertex.x;
+			vertex.v = vertex.z;
+			break;
+		case 2:
+			vertex.u = cell.x - vertex.x;
+			vertex.v = cell.y - vertex.y;
+			break;
+		case 3:
+			vertex.u = vertex.x;
+			vertex.v = cell.y - vertex.y;
+			break;
+		case 4:
+			vertex.u = vertex.z;
+			vertex.v = cell.y - vertex.y;
+			break;
+		default:
+			vertex.u = cell.z - vertex.z;
+			vertex.v = cell.y - vertex.y;
+			break;
+		}
+	}
+}
+
+void TessellationTemplateCache::_addQuad(std::vector<Quad>& quads, const AABB& box, FacingID face, const TextureUVCoordinateSet& uv)
+{
+	Quad quad;
+	quad.face = face;
+	getFaceCorners(box, face, Vec3(1.0F, 1.0F, 1.0F), quad.corners);
+	for(int i = 0; i < 4; i++)
+	{
+		Vertex& vertex = quad.corners[i];
+		vertex.u = _lerp(uv._u0, uv._u1, vertex.u);
+		vertex.v = _lerp(uv._v0, uv._v1, vertex.v);
+	}
+
+	switch(face)
+	{
+	case 0:
+		quad.inner = box.min.y > 0.0F;
+		break;
+	case 1:
+		quad.inner = box.max.y < 1.0F;
+		break;
+	case 2:
+		quad.inner = box.min.z > 0.0F;
+		break;
+	case 3:
+		quad.inner = box.max.z < 1.0F;
+		break;
+	case 4:
+		quad.inner = box.min.x > 0.0F;
+		break;
+	default:
+		quad.inner = box.max.x < 1.0F;
+		break;
+	}
+
+	quads.push_back(quad);
+}
+
+void TessellationTemplateCache::_buildTemplate(Snapshot& cache, const TileStateTable::Snapshot& states, Tile& tile, DataID data)
+{
+	std::vector<Quad>& quads = cache.quads;
+	Template& entry = cache.templates[tile.blockId][data];
+	const AABB* box = states.getShape(tile.blockId, data);
+
+	entry.first = quads.size();
+	for(int face = 0; face < 6; face++)
+	{
+		entry.faceBegin[face] = quads.size() - entry.first;
+		if(box)
+		{
+			_addQuad(quads, *box, face, states.getUV(tile.blockId, data, face));
+		}
+	}
+	entry.faceBegin[6] = quads.size() - entry.first;
+	entry.built = true;
+}
+
+void TessellationTemplateCache::_publish(std::shared_ptr<Snapshot> cache)
+{
+	std::atomic_store_explicit(&current, std::shared_ptr<const Snapshot>(std::move(cache)), std::memory_order_release);
+}
+
+/* Only standard blocks (render shape 0) that don't depend on their position get quads,
+	the tessellator keeps its own path for the others; every registered tile gets its
+	getTessellatedUVs() cached. Reads TileStateTable, so that one is built first.
+*/
+void TessellationTemplateCache::build()
+{
+	std::shared_ptr<Snapshot> cache = std::make_shared<Snapshot>();
+	TileStateTable::Ref states = TileStateTable::acquire();
+	for(int i = 0; i < 256; i++)
+	{
+		Tile* tile = Tile::tiles[i];
+		if(!tile)
+		{
+			continue;
+		}
+
+		std::vector<TessellatedUV> uvs = tile->getTessellatedUVs();
+		cache->uvFirst[i] = cache->tessellatedUVs.size();
+		cache->uvCount[i] = uvs.size();
+		cache->tessellatedUVs.insert(cache->tessellatedUVs.end(), uvs.begin(), uvs.end());
+
+		for(int data = 0; data < 16; data++)
+		{
+			const TileStateTable::State& state = states->get(i, data);
+			if(state.renderShape == 0 && !(state.flags & TileStateTable::POSITION_DEPENDENT))
+			{
+				_buildTemplate(*cache, *states, *tile, data);
+			}
+		}
+	}
+
+	cache->generation = TileTextureTable::getGeneration();
+	_publish(std::move(cache));
+}
+
+void TessellationTemplateCache::clear()
+{
+	_publish(std::make_shared<Snapshot>());
+}
+
+void TessellationTemplateCache::ensureCurrent()
+{
+	if(acquire()->generation != TileTextureTable::getGeneration())
+	{
+		build();
+	}
+}
+
+TessellationTemplateCache::Span<TessellationTemplateCache::Quad> TessellationTemplateCache::Snapshot::get(TileID blockId, DataID data) const
+{
+	const Template& entry = templates[blockId][data & 15];
+	Span<Quad> span = {quads.data() + entry.first, entry.faceBegin[6]};
+	return span;
+}
+
+TessellationTemplateCache::Span<TessellationTemplateCache::Quad> TessellationTemplateCache::Snapshot::getFace(TileID blockId, DataID data, FacingID face) const
+{
+	const Template& entry = templates[blockId][data & 15];
+	Span<Quad> span = {quads.data() + entry.first + entry.faceBegin[face], entry.faceBegin[face + 1] - entry.faceBegin[face]};
+	return span;
+}
+
+TessellationTemplateCache::Span<TessellationTemplateCache::TessellatedUV> TessellationTemplateCache::Snapshot::getTessellatedUVs(TileID blockId) const
+{
+	Span<TessellatedUV> span = {tessellatedUVs.data() + uvFirst[blockId], (int) uvCount[blockId]};
+	return span;
+}
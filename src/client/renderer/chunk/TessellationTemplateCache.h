@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "world/level/tile/TileStateTable.h"
+
+/* Precomputed quads per (tile ID, data)
+	Built once from the TileStateTable shapes and UVs after initTiles and
+	again whenever the texture atlas changes; the tessellator only offsets the corners by
+	the tile position and applies light and tint. Faces are stored contiguously in face
+	order so a culled face is skipped as a whole. getTessellatedUVs() is cached per ID the
+	same way instead of being called, and allocating, once per block.
+
+	Each build is a new Snapshot published with an atomic store, as TileStateTable does.
+	Spans point into the snapshot, so the tessellator takes a Ref with acquire() once per
+	section and reads the spans through it.
+*/
+class TessellationTemplateCache
+{
+public:
+	struct Vertex
+	{
+		float x, y, z; // tile-local
+		float u, v;
+	};
+
+	struct Quad
+	{
+		Vertex corners[4];
+		FacingID face;
+		bool inner; // the face doesn't lie on the cell border, so it's never culled
+	};
+
+	template<typename T>
+	struct Span
+	{
+		const T* data;
+		int count;
+
+		const T* begin() const { return data; }
+		const T* end() const { return data + count; }
+		bool empty() const { return count == 0; }
+		const T& operator[](int i) const { return data[i]; }
+	};
+
+	typedef std::pair<TextureUVCoordinateSet, Rect2D> TessellatedUV;
+
+	struct Template
+	{
+		uint32_t first;
+		uint8_t faceBegin[7]; // offsets from first, faceBegin[6] is the quad count
+		bool built;
+	};
+
+	struct Snapshot
+	{
+		Template templates[256][16];
+		std::vector<Quad> quads;
+		std::vector<TessellatedUV> tessellatedUVs;
+		uint32_t uvFirst[256], uvCount[256];
+		uint32_t generation; // of the TileTextureTable it was built against
+
+		bool has(TileID blockId, DataID data) const { return templates[blockId][data & 15].built; }
+		Span<Quad> get(TileID blockId, DataID data) const;
+		Span<Quad> getFace(TileID blockId, DataID data, FacingID face) const;
+		Span<TessellatedUV> getTessellatedUVs(TileID blockId) const;
+	};
+
+	typedef std::shared_ptr<const Snapshot> Ref;
+
+	static void build();
+	static void clear();
+	/* Rebuilds if the texture table was swapped since the last build */
+	static void ensureCurrent();
+
+	/* The current templates, valid for as long as the caller holds them */
+	static Ref acquire() { return std::atomic_load_explicit(&current, std::memory_order_acquire); }
+	static bool has(TileID blockId, DataID data) { return acquire()->has(blockId, data); }
+
+	/* Corners of a face of box in tessellator order, u and v are where they fall on a cell of
+		the given size (1 for one tile), flipped as the tessellator flips them, before the
+		atlas mapping */
+	static void getFaceCorners(const AABB& box, FacingID face, const Vec3& cell, Vertex corners[4]);
+
+private:
+	static std::shared_ptr<const Snapshot> current;
+
+	static void _publish(std::shared_ptr<Snapshot>);
+	static void _buildTemplate(Snapshot&, const TileStateTable::Snapshot&, Tile&, DataID);
+	static void _addQuad(std::vector<Quad>&, const AABB&, FacingID, const TextureUVCoordinateSet&);
+	static float _lerp(float, float, float);
+};
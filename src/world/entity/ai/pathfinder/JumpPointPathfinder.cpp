@@ -0,0 +1,429 @@
+#include "JumpPointPathfinder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "NavGrid.h"
+
+static const float DIAGONAL_EXTRA = 0.41421356F; // sqrt(2) - 1
+static const int STAND_OFFSETS[3] = {0, 1, -1};
+
+static int _sign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+JumpPointPathfinder::JumpPointPathfinder(const NavGrid& grid, int budget, int maxNodesPerSearch)
+	: grid(grid)
+{
+	this->budget = budget;
+	spent = 0;
+	maxNodes = maxNodesPerSearch;
+	nextId = 1;
+	active = false;
+	stats = Stats();
+}
+
+void JumpPointPathfinder::setBudget(int _budget)
+{
+	budget = _budget > 1? _budget : 1;
+}
+
+JumpPointPathfinder::RequestID JumpPointPathfinder::request(const TilePos& from, const TilePos& to)
+{
+	Request req = {nextId++, from, to};
+	requests.push_back(req);
+	results[req.id].status = PENDING;
+	return req.id;
+}
+
+void JumpPointPathfinder::cancel(RequestID id)
+{
+	if(active && current.id == id)
+	{
+		active = false;
+	}
+
+	for(auto it = requests.begin(); it != requests.end(); ++it)
+	{
+		if(it->id == id)
+		{
+			requests.erase(it);
+			break;
+		}
+	}
+
+	results.erase(id);
+}
+
+JumpPointPathfinder::Status JumpPointPathfinder::getResult(RequestID id, std::vector<TilePos>& path)
+{
+	auto it = results.find(id);
+	if(it == results.end())
+	{
+		return UNKNOWN_REQUEST;
+	}
+
+	Status status = it->second.status;
+	if(status != PENDING)
+	{
+		path.swap(it->second.path);
+		results.erase(it);
+	}
+
+	return status;
+}
+
+float JumpPointPathfinder::_heuristic(int x, int z) const
+{
+	int dx = abs(x - current.to.x);
+	int dz = abs(z - current.to.z);
+	return (float) std::max(dx, dz) + DIAGONAL_EXTRA * std::min(dx, dz);
+}
+
+/* Same height first, then one up, then one down */
+bool JumpPointPathfinder::_standY(TileSource& region, int x, int y, int z, int& outY) const
+{
+	for(int i = 0; i < 3; i++)
+	{
+		if(grid.isWalkable(region, x, y + STAND_OFFSETS[i], z))
+		{
+			outY = y + STAND_OFFSETS[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JumpPointPathfinder::_canMove(TileSource& region, int x, int y, int z, int dx, int dz, int& outY) const
+{
+	if(dx && dz)
+	{
+		/* no corner cutting and no climbing diagonally */
+		outY = y;
+		return grid.isWalkable(region, x + dx, y, z) && grid.isWalkable(region, x, y, z + dz) && grid.isWalkable(region, x + dx, y, z + dz);
+	}
+
+	if(!_standY(region, x + dx, y, z + dz, outY))
+	{
+		return false;
+	}
+
+	/* stepping up needs headroom over the current tile */
+	return outY <= y || grid.isPassable(region, x, y + 2, z);
+}
+
+/* Diagonals never cut corners, so a straight run only has to stop where a wall beside it
+	ends: the side can be stepped onto from here but not from the cell behind. A diagonal
+	run has no forced neighbours of its own, its straight sub-runs find them.
+*/
+bool JumpPointPathfinder::_hasForced(TileSource& region, int x, int y, int z, int dx, int dz) const
+{
+	if(dx && dz)
+	{
+		return false;
+	}
+
+	/* the two sides perpendicular to the move */
+	int sx = dz, sz = dx;
+	int standY;
+	for(int side = -1; side <= 1; side += 2)
+	{
+		int ox = sx * side, oz = sz * side;
+		if(_canMove(region, x, y, z, ox, oz, standY) && !_canMove(region, x - dx, y, z - dz, ox, oz, standY))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JumpPointPathfinder::_jump(TileSource& region, int x, int y, int z, int dx, int dz, int& jx, int& jy, int& jz)
+{
+	for(int step = 0; step < MAX_JUMP; step++)
+	{
+		/* out of budget, the run ends in a node here and carries on next tick */
+		if(step > 0 && spent >= budget)
+		{
+			return true;
+		}
+		spent++;
+		stats.probes++;
+
+		int ny;
+		if(!_canMove(region, x, y, z, dx, dz, ny))
+		{
+			return false;
+		}
+
+		bool climbed = ny != y;
+		x += dx;
+		y = ny;
+		z += dz;
+		jx = x;
+		jy = y;
+		jz = z;
+
+		if((x == current.to.x && z == current.to.z) || climbed || _hasForced(region, x, y, z, dx, dz))
+		{
+			return true;
+		}
+
+		/* a diagonal stops where either straight component finds something */
+		if(dx && dz)
+		{
+			int ix, iy, iz;
+			if(_jump(region, x, y, z, dx, 0, ix, iy, iz) || _jump(region, x, y, z, 0, dz, ix, iy, iz))
+			{
+				return true;
+			}
+		}
+
+		stats.jumps++;
+	}
+
+	/* long runs end in a node anyway so the search keeps a foothold */
+	return true;
+}
+
+void JumpPointPathfinder::_push(int x, int y, int z, float g, int parent)
+{
+	uint64_t key = _key(x, y, z);
+	auto it = nodeAt.find(key);
+	int index;
+	if(it != nodeAt.end())
+	{
+		Node& node = nodes[it->second];
+		if(node.closed || g >= node.g)
+		{
+			return;
+		}
+		node.g = g;
+		node.f = g + _heuristic(x, z);
+		node.parent = parent;
+		index = it->second;
+	}
+	else
+	{
+		Node node = {x, y, z, g, g + _heuristic(x, z), parent, false};
+		index = nodes.size();
+		nodes.push_back(node);
+		nodeAt[key] = index;
+	}
+
+	/* a cheaper path re-pushes the node, the stale heap entry is skipped once closed */
+	open.push_back(index);
+	std::push_heap(open.begin(), open.end(), [this](int a, int b) { return nodes[a].f > nodes[b].f; });
+}
+
+int JumpPointPathfinder::_pop()
+{
+	while(!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end(), [this](int a, int b) { return nodes[a].f > nodes[b].f; });
+		int index = open.back();
+		open.pop_back();
+		if(!nodes[index].closed)
+		{
+			nodes[index].closed = true;
+			return index;
+		}
+	}
+
+	return -1;
+}
+
+void JumpPointPathfinder::_expand(TileSource& region, int index)
+{
+	Node node = nodes[index];
+	int dirs[8][2];
+	int count = 0;
+
+	bool unpruned = node.parent < 0 || nodes[node.parent].y != node.y;
+	if(unpruned)
+	{
+		for(int dx = -1; dx <= 1; dx++)
+		{
+			for(int dz = -1; dz <= 1; dz++)
+			{
+				if(dx || dz)
+				{
+					dirs[count][0] = dx;
+					dirs[count][1] = dz;
+					count++;
+				}
+			}
+		}
+	}
+	else
+	{
+		const Node& parent = nodes[node.parent];
+		int dx = _sign(node.x - parent.x);
+		int dz = _sign(node.z - parent.z);
+
+		if(dx && dz)
+		{
+			int natural[3][2] = {{dx, 0}, {0, dz}, {dx, dz}};
+			for(int i = 0; i < 3; i++)
+			{
+				dirs[count][0] = natural[i][0];
+				dirs[count][1] = natural[i][1];
+				count++;
+			}
+		}
+		else
+		{
+			/* ahead, both sides, and the diagonals ahead toward a side that is open */
+			dirs[count][0] = dx;
+			dirs[count][1] = dz;
+			count++;
+
+			int sx = dz, sz = dx;
+			int standY;
+			for(int side = -1; side <= 1; side += 2)
+			{
+				int ox = sx * side, oz = sz * side;
+				dirs[count][0] = ox;
+				dirs[count][1] = oz;
+				count++;
+				if(grid.isWalkable(region, node.x + ox, node.y, node.z + oz) && _canMove(region, node.x, node.y, node.z, dx, dz, standY))
+				{
+					dirs[count][0] = dx + ox;
+					dirs[count][1] = dz + oz;
+					count++;
+				}
+			}
+		}
+	}
+
+	for(int i = 0; i < count; i++)
+	{
+		int jx, jy, jz;
+		if(!_jump(region, node.x, node.y, node.z, dirs[i][0], dirs[i][1], jx, jy, jz))
+		{
+			continue;
+		}
+
+		int ax = abs(jx - node.x), az = abs(jz - node.z);
+		float cost = (float) std::max(ax, az) + DIAGONAL_EXTRA * std::min(ax, az) + abs(jy - node.y) * 0.5F;
+		_push(jx, jy, jz, node.g + cost, index);
+	}
+}
+
+void JumpPointPathfinder::_start(TileSource& region, const Request& req)
+{
+	current = req;
+	active = true;
+	nodes.clear();
+	nodeAt.clear();
+	open.clear();
+	stats.searches++;
+
+	int startY, goalY;
+	if(!_standY(region, req.from.x, req.from.y, req.from.z, startY) || !_standY(region, req.to.x, req.to.y, req.to.z, goalY))
+	{
+		_finish(NOT_FOUND);
+		return;
+	}
+
+	current.to.y = goalY;
+	_push(req.from.x, startY, req.from.z, 0.0F, -1);
+}
+
+void JumpPointPathfinder::_finish(Status status)
+{
+	active = false;
+	auto it = results.find(current.id);
+	if(it != results.end())
+	{
+		it->second.status = status;
+	}
+}
+
+/* Jump points back to the start, then the straight runs between them filled in cell by cell */
+void JumpPointPathfinder::_buildPath(TileSource& region, int index, std::vector<TilePos>& path) const
+{
+	std::vector<int> points;
+	for(int i = index; i >= 0; i = nodes[i].parent)
+	{
+		points.push_back(i);
+	}
+	std::reverse(points.begin(), points.end());
+
+	path.clear();
+	const Node& first = nodes[points[0]];
+	path.push_back(TilePos(first.x, first.y, first.z));
+	for(size_t i = 1; i < points.size(); i++)
+	{
+		const Node& from = nodes[points[i - 1]];
+		const Node& to = nodes[points[i]];
+		int dx = _sign(to.x - from.x), dz = _sign(to.z - from.z);
+		int x = from.x, y = from.y, z = from.z;
+		while(x != to.x || z != to.z)
+		{
+			x += (x != to.x)? dx : 0;
+			z += (z != to.z)? dz : 0;
+			if(x == to.x && z == to.z)
+			{
+				y = to.y;
+			}
+			else
+			{
+				_standY(region, x, y, z, y);
+			}
+			path.push_back(TilePos(x, y, z));
+		}
+	}
+}
+
+void JumpPointPathfinder::tick(TileSource& region)
+{
+	spent = 0;
+	while(spent < budget)
+	{
+		if(!active)
+		{
+			if(requests.empty())
+			{
+				break;
+			}
+
+			Request req = requests.front();
+			requests.pop_front();
+			_start(region, req);
+			continue;
+		}
+
+		int index = _pop();
+		if(index < 0)
+		{
+			_finish(NOT_FOUND);
+			continue;
+		}
+
+		const Node& node = nodes[index];
+		if(node.x == current.to.x && node.y == current.to.y && node.z == current.to.z)
+		{
+			auto it = results.find(current.id);
+			if(it != results.end())
+			{
+				_buildPath(region, index, it->second.path);
+			}
+			_finish(FOUND);
+			continue;
+		}
+
+		spent++;
+		stats.probes++;
+		_expand(region, index);
+		stats.expanded++;
+
+		if((int) nodes.size() > maxNodes)
+		{
+			_finish(NOT_FOUND);
+		}
+	}
+}
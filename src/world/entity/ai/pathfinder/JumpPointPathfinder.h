@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+class NavGrid;
+
+/* A* over the walkable surface of a NavGrid with jump point pruning
+	Moves are the 8 horizontal neighbours, stepping up or down one tile; diagonals need
+	both sides free, so the pruning rules are the ones for searches that never cut
+	corners: a straight run stops where a wall beside it ends, and its node expands
+	ahead, both sides and the diagonals toward open sides. On flat ground a run is
+	followed without queueing the cells along it until that, a height change or the
+	goal turns up, so open fields cost a handful of nodes instead of hundreds.
+
+	Requests are queued and run one at a time against a node arena that is reused
+	between searches. tick() spends at most 'budget' grid probes, every expanded node
+	and every cell a jump crosses costs one. A jump that runs out of budget ends in a
+	node where it stopped and the search resumes from there on the next tick, so long
+	runs and a crowd of mobs asking at once both spread over ticks.
+*/
+class JumpPointPathfinder
+{
+public:
+	typedef int RequestID;
+
+	enum Status
+	{
+		PENDING,
+		FOUND,
+		NOT_FOUND,
+		UNKNOWN_REQUEST
+	};
+
+	struct Stats
+	{
+		int searches;
+		int expanded;
+		int jumps; // cells crossed by jumps without becoming nodes
+		int probes; // budget spent
+	};
+
+	static const int MAX_JUMP = 32;
+
+	JumpPointPathfinder(const NavGrid& grid, int budget = 2048, int maxNodesPerSearch = 4096);
+
+	void setBudget(int);
+	int getBudget() const { return budget; }
+
+	RequestID request(const TilePos& from, const TilePos& to);
+	void cancel(RequestID);
+	/* For FOUND, path receives every cell from start to goal */
+	Status getResult(RequestID, std::vector<TilePos>& path);
+
+	void tick(TileSource&);
+
+	const Stats& getStats() const { return stats; }
+	void resetStats() { stats = Stats(); }
+
+private:
+	struct Node
+	{
+		int x, y, z;
+		float g, f;
+		int parent;
+		bool closed;
+	};
+
+	struct Request
+	{
+		RequestID id;
+		TilePos from, to;
+	};
+
+	struct Result
+	{
+		Status status;
+		std::vector<TilePos> path;
+	};
+
+	const NavGrid& grid;
+	int budget;
+	int spent; // this tick
+	int maxNodes;
+	RequestID nextId;
+
+	std::deque<Request> requests;
+	std::unordered_map<RequestID, Result> results;
+
+	/* the search in progress, the arena and index are cleared, not freed, between searches */
+	bool active;
+	Request current;
+	std::vector<Node> nodes;
+	std::unordered_map<uint64_t, int> nodeAt;
+	std::vector<int> open; // binary heap on f
+
+	Stats stats;
+
+	static uint64_t _key(int x, int y, int z)
+	{
+		return ((uint64_t) (x & 0x3FFFFFF) << 38) | ((uint64_t) (z & 0x3FFFFFF) << 12) | (uint64_t) (y & 0xFFF);
+	}
+
+	void _start(TileSource&, const Request&);
+	void _finish(Status);
+	void _push(int x, int y, int z, float g, int parent);
+	int _pop();
+	float _heuristic(int x, int z) const;
+	bool _standY(TileSource&, int x, int y, int z, int& outY) const;
+	bool _canMove(TileSource&, int x, int y, int z, int dx, int dz, int& outY) const;
+	bool _jump(TileSource&, int x, int y, int z, int dx, int dz, int& jx, int& jy, int& jz);
+	bool _hasForced(TileSource&, int x, int y, int z, int dx, int dz) const;
+	void _expand(TileSource&, int node);
+	void _buildPath(TileSource&, int node, std::vector<TilePos>&) const;
+};
@@ -0,0 +1,132 @@
+#include "NavGrid.h"
+
+#include <cstring>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+#include "world/level/tile/TileCapabilities.h"
+
+NavGrid::CellClass NavGrid::classes[256];
+
+void NavGrid::buildClasses()
+{
+	for(int id = 0; id < 256; id++)
+	{
+		Tile* tile = Tile::tiles[id];
+		if(!tile)
+		{
+			classes[id] = OPEN;
+		}
+		else if(TileCapabilities::has(id, TileCapabilities::PATHFINDABLE))
+		{
+			classes[id] = DYNAMIC;
+		}
+		else
+		{
+			classes[id] = TileProperties::blocksMotion(id)? BLOCKED : OPEN;
+		}
+	}
+
+	Tile* hazards[] = {Tile::lava, Tile::calmLava, (Tile*) Tile::fire, Tile::cactus, Tile::web};
+	for(Tile* hazard : hazards)
+	{
+		if(hazard)
+		{
+			classes[hazard->blockId] = HAZARD;
+		}
+	}
+}
+
+void NavGrid::_set(NavChunk& chunk, int index, CellClass cellClass)
+{
+	uint64_t& word = chunk.words[index >> 5];
+	int shift = (index & 31) * 2;
+	word = (word & ~((uint64_t) 3 << shift)) | ((uint64_t) cellClass << shift);
+}
+
+void NavGrid::onChunkLoaded(int cx, int cz, const TileID* blocks)
+{
+	std::unique_ptr<NavChunk>& chunk = chunks[_key(cx, cz)];
+	if(!chunk)
+	{
+		chunk.reset(new NavChunk());
+	}
+
+	/* 32 cells per word, packed straight from the ID array */
+	for(int w = 0; w < (int) (sizeof(chunk->words) / sizeof(uint64_t)); w++)
+	{
+		uint64_t word = 0;
+		const TileID* ids = blocks + w * 32;
+		for(int i = 0; i < 32; i++)
+		{
+			word |= (uint64_t) classes[ids[i]] << (i * 2);
+		}
+		chunk->words[w] = word;
+	}
+}
+
+void NavGrid::onChunkUnloaded(int cx, int cz)
+{
+	chunks.erase(_key(cx, cz));
+}
+
+void NavGrid::onTileChanged(int x, int y, int z, TileID newId)
+{
+	auto it = chunks.find(_key(x >> 4, z >> 4));
+	if(it == chunks.end() || y < 0 || y >= HEIGHT)
+	{
+		return;
+	}
+
+	_set(*it->second, _index(x, y, z), classes[newId]);
+}
+
+const NavGrid::NavChunk* NavGrid::_find(int cx, int cz) const
+{
+	auto it = chunks.find(_key(cx, cz));
+	return it != chunks.end()? it->second.get() : NULL;
+}
+
+NavGrid::CellClass NavGrid::get(int x, int y, int z) const
+{
+	if(y < 0 || y >= HEIGHT)
+	{
+		return BLOCKED;
+	}
+
+	const NavChunk* chunk = _find(x >> 4, z >> 4);
+	if(!chunk)
+	{
+		return BLOCKED;
+	}
+
+	int index = _index(x, y, z);
+	return (CellClass) ((chunk->words[index >> 5] >> ((index & 31) * 2)) & 3);
+}
+
+bool NavGrid::isPassable(TileSource& region, int x, int y, int z) const
+{
+	CellClass cellClass = get(x, y, z);
+	if(cellClass == DYNAMIC)
+	{
+		return Tile::tiles[region.getTile(x, y, z).blockId]->isPathfindable(&region, x, y, z);
+	}
+
+	return cellClass == OPEN;
+}
+
+bool NavGrid::isFloor(TileSource& region, int x, int y, int z) const
+{
+	CellClass cellClass = get(x, y, z);
+	if(cellClass == DYNAMIC)
+	{
+		return !Tile::tiles[region.getTile(x, y, z).blockId]->isPathfindable(&region, x, y, z);
+	}
+
+	return cellClass == BLOCKED;
+}
+
+bool NavGrid::isWalkable(TileSource& region, int x, int y, int z) const
+{
+	return isFloor(region, x, y - 1, z) && isPassable(region, x, y, z) && isPassable(region, x, y + 1, z);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+/* Two bits of navigation class per cell, per loaded chunk
+	OPEN and BLOCKED come from TileProperties::blocksMotion, which is all the base
+	Tile::isPathfindable looks at. Lava, fire, cactus and webs are HAZARD, and tiles that
+	answer isPathfindable themselves (doors, gates) are DYNAMIC and get asked at search
+	time, both as the cell a mob walks through and as the floor under it. A tile change
+	rewrites its one cell.
+*/
+class NavGrid
+{
+public:
+	enum CellClass : uint8_t
+	{
+		OPEN,
+		BLOCKED,
+		HAZARD,
+		DYNAMIC
+	};
+
+	static const int HEIGHT = 128;
+
+	/* Rebuilds the per-ID class table, after initTiles */
+	static void buildClasses();
+	static CellClass getClass(TileID blockId) { return classes[blockId]; }
+
+	/* blocks is the chunk's ID array in LevelChunk order, (x << 11) | (z << 7) | y */
+	void onChunkLoaded(int cx, int cz, const TileID* blocks);
+	void onChunkUnloaded(int cx, int cz);
+	void onTileChanged(int x, int y, int z, TileID newId);
+
+	bool isLoaded(int x, int z) const { return _find(x >> 4, z >> 4) != NULL; }
+	/* Unloaded chunks and positions outside the height read as BLOCKED */
+	CellClass get(int x, int y, int z) const;
+
+	bool isPassable(TileSource&, int x, int y, int z) const;
+	/* Something under y that blocks motion, a closed door counts */
+	bool isFloor(TileSource&, int x, int y, int z) const;
+	/* Standing room at y: two passable cells over a floor */
+	bool isWalkable(TileSource&, int x, int y, int z) const;
+
+private:
+	struct NavChunk
+	{
+		uint64_t words[16 * 16 * HEIGHT * 2 / 64];
+	};
+
+	static CellClass classes[256];
+
+	std::unordered_map<int64_t, std::unique_ptr<NavChunk>> chunks;
+
+	static int64_t _key(int cx, int cz)
+	{
+		return ((int64_t) cx << 32) | (uint32_t) cz;
+	}
+
+	static int _index(int x, int y, int z)
+	{
+		return ((x & 15) << 11) | ((z & 15) << 7) | y;
+	}
+
+	const NavChunk* _find(int cx, int cz) const;
+	static void _set(NavChunk&, int index, CellClass);
+};
@@ -0,0 +1,132 @@
+#include "ItemDropBatch.h"
+
+#include "world/level/Level.h"
+#include "world/entity/item/ItemEntity.h"
+
+thread_local std::vector<TileSource*> ItemDropBatch::regions;
+thread_local std::vector<ItemDropBatch::Drop> ItemDropBatch::drops;
+thread_local std::unordered_map<uint64_t, int> ItemDropBatch::open;
+std::atomic<uint64_t> ItemDropBatch::totalDrops(0);
+std::atomic<uint64_t> ItemDropBatch::totalSpawned(0);
+
+void ItemDropBatch::begin(TileSource& region)
+{
+	regions.push_back(&region);
+}
+
+void ItemDropBatch::end()
+{
+	if(regions.empty())
+	{
+		return;
+	}
+
+	TileSource* region = regions.back();
+	regions.pop_back();
+	if(!regions.empty() && regions.back() == region)
+	{
+		return;
+	}
+
+	/* the outermost batch spawns everything, a nested one only what went through its own region */
+	uint64_t spawned = 0;
+	size_t kept = 0;
+	for(size_t i = 0; i < drops.size(); i++)
+	{
+		if(regions.empty() || drops[i].region == region)
+		{
+			spawn(*drops[i].region, drops[i].pos, drops[i].item);
+			spawned++;
+		}
+		else
+		{
+			drops[kept++] = drops[i];
+		}
+	}
+	totalSpawned.fetch_add(spawned, std::memory_order_relaxed);
+
+	drops.resize(kept);
+	open.clear();
+	for(size_t i = 0; i < drops.size(); i++)
+	{
+		if(drops[i].item.isStackable())
+		{
+			open[_key(drops[i].pos, drops[i].item)] = i;
+		}
+	}
+}
+
+bool ItemDropBatch::add(TileSource& region, const TilePos& pos, const ItemInstance& item)
+{
+	if(regions.empty())
+	{
+		return false;
+	}
+
+	totalDrops.fetch_add(1, std::memory_order_relaxed);
+
+	/* items carrying their own data never stack, keep them as they are */
+	if(!item.isStackable())
+	{
+		Drop drop = {&region, pos, item};
+		drops.push_back(drop);
+		return true;
+	}
+
+	uint64_t key = _key(pos, item);
+	auto it = open.find(key);
+	int count = item.count;
+	if(it != open.end() && _matches(drops[it->second], &region, pos, item))
+	{
+		ItemInstance& stack = drops[it->second].item;
+		int room = stack.getMaxStackSize() - stack.count;
+		int moved = count < room? count : room;
+		stack.count += moved;
+		count -= moved;
+		if(count == 0)
+		{
+			return true;
+		}
+	}
+
+	/* the previous stack is full, the rest starts a new one */
+	Drop drop = {&region, pos, item};
+	drop.item.count = count;
+	open[key] = drops.size();
+	drops.push_back(drop);
+	return true;
+}
+
+ItemDropBatch::Stats ItemDropBatch::getStats()
+{
+	Stats stats;
+	stats.drops = totalDrops.load(std::memory_order_relaxed);
+	stats.spawned = totalSpawned.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void ItemDropBatch::resetStats()
+{
+	totalDrops.store(0, std::memory_order_relaxed);
+	totalSpawned.store(0, std::memory_order_relaxed);
+}
+
+void ItemDropBatch::spawn(TileSource& region, const TilePos& pos, const ItemInstance& item)
+{
+	ItemEntity* droppedItem = new ItemEntity(region, (float) pos.x, (float) pos.y, (float) pos.z, item);
+	droppedItem->throwTime = 10;
+	region.getLevel()->addEntity(droppedItem);
+}
+
+bool ItemDropBatch::_matches(const Drop& drop, TileSource* region, const TilePos& pos, const ItemInstance& item)
+{
+	return drop.region == region && drop.pos.x == pos.x && drop.pos.y == pos.y && drop.pos.z == pos.z &&
+		drop.item.getId() == item.getId() && drop.item.getAuxValue() == item.getAuxValue();
+}
+
+/* Hashes cell and item, a collision only costs a separate stack since add() checks the match */
+uint64_t ItemDropBatch::_key(const TilePos& pos, const ItemInstance& item)
+{
+	uint64_t key = ((uint64_t) (pos.x & 0xFFFFF) << 44) | ((uint64_t) (pos.z & 0xFFFFF) << 24) | ((uint64_t) (pos.y & 0xFF) << 16);
+	return key ^ ((uint64_t) (item.getId() & 0xFFF) << 4) ^ ((uint64_t) item.getAuxValue() << 32);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Spawn-time merging of tile drops
+	While a batch is open, Tile::popResource hands its drop here instead of creating an
+	ItemEntity. Drops of the same item and aux value in the same tile cell are folded
+	into one stack (up to its max stack size) and end() spawns one entity per stack,
+	each into the TileSource it was dropped through.
+	Batches belong to the thread that opened them, every thread running ticks has its
+	own, so a drop only ever joins a batch its own thread opened. Batches nest: a nested
+	end() leaves its drops to the enclosing batch when both use the same TileSource and
+	spawns them itself otherwise, since its TileSource may not outlive it. The drop
+	records are kept between batches so a steady stream of explosions doesn't allocate.
+*/
+class ItemDropBatch
+{
+public:
+	struct Stats
+	{
+		uint64_t drops;
+		uint64_t spawned;
+
+		/* ItemEntity allocations the merge saved */
+		uint64_t getAllocationsAvoided() const { return drops - spawned; }
+	};
+
+	static void begin(TileSource&);
+	static void end();
+	static bool isOpen() { return !regions.empty(); }
+
+	/* Returns false if this thread has no batch open, the caller spawns the drop itself */
+	static bool add(TileSource&, const TilePos&, const ItemInstance&);
+
+	/* Summed over every thread */
+	static Stats getStats();
+	static void resetStats();
+
+	/* The ItemEntity popResource would have created on its own */
+	static void spawn(TileSource&, const TilePos&, const ItemInstance&);
+
+private:
+	struct Drop
+	{
+		TileSource* region;
+		TilePos pos;
+		ItemInstance item;
+	};
+
+	static thread_local std::vector<TileSource*> regions; // one per open batch, innermost last
+	static thread_local std::vector<Drop> drops;
+	static thread_local std::unordered_map<uint64_t, int> open; // cell and item to the stack still filling up
+	static std::atomic<uint64_t> totalDrops, totalSpawned;
+
+	static bool _matches(const Drop&, TileSource*, const TilePos&, const ItemInstance&);
+	static uint64_t _key(const TilePos&, const ItemInstance&);
+};
@@ -0,0 +1,221 @@
+#include "ChunkTickQueue.h"
+
+ChunkTickQueue::ChunkTickQueue(int cx, int cz, uint32_t currentTick)
+{
+	this->cx = cx;
+	this->cz = cz;
+	cursor = currentTick;
+	freeList = NONE;
+	for(int i = 0; i < LIST_COUNT; i++)
+	{
+		heads[i] = NONE;
+	}
+}
+
+TilePos ChunkTickQueue::_worldPos(uint16_t localPos) const
+{
+	return TilePos((cx << 4) | (localPos >> 11), localPos & 127, (cz << 4) | ((localPos >> 7) & 15));
+}
+
+/* Picks the lowest level whose span still contains both the cursor and the due tick */
+int ChunkTickQueue::_listFor(uint32_t dueTick) const
+{
+	if((dueTick >> 8) == (cursor >> 8))
+	{
+		return dueTick & (LEVEL0_SLOTS - 1);
+	}
+	if((dueTick >> 14) == (cursor >> 14))
+	{
+		return LEVEL1_BASE + ((dueTick >> 8) & (LEVEL1_SLOTS - 1));
+	}
+	if((dueTick >> 20) == (cursor >> 20))
+	{
+		return LEVEL2_BASE + ((dueTick >> 14) & (LEVEL2_SLOTS - 1));
+	}
+
+	return OVERFLOW_LIST;
+}
+
+int32_t ChunkTickQueue::_allocNode()
+{
+	if(freeList != NONE)
+	{
+		int32_t node = freeList;
+		freeList = nodes[node].next;
+		return node;
+	}
+
+	nodes.push_back(Node());
+	return nodes.size() - 1;
+}
+
+void ChunkTickQueue::_freeNode(int32_t node)
+{
+	nodes[node].list = NONE;
+	nodes[node].next = freeList;
+	freeList = node;
+}
+
+/* Lists are circular, the head's prev is the tail, so appending keeps FIFO order */
+void ChunkTickQueue::_link(int32_t node, int list)
+{
+	Node& entry = nodes[node];
+	entry.list = list;
+
+	int32_t head = heads[list];
+	if(head == NONE)
+	{
+		entry.prev = node;
+		entry.next = node;
+		heads[list] = node;
+		return;
+	}
+
+	int32_t tail = nodes[head].prev;
+	entry.prev = tail;
+	entry.next = head;
+	nodes[tail].next = node;
+	nodes[head].prev = node;
+}
+
+void ChunkTickQueue::_unlink(int32_t node)
+{
+	Node& entry = nodes[node];
+	int list = entry.list;
+	if(entry.next == node)
+	{
+		heads[list] = NONE;
+	}
+	else
+	{
+		nodes[entry.prev].next = entry.next;
+		nodes[entry.next].prev = entry.prev;
+		if(heads[list] == node)
+		{
+			heads[list] = entry.next;
+		}
+	}
+	entry.list = NONE;
+}
+
+/* Re-files every entry of a higher level list now that the cursor entered its span */
+void ChunkTickQueue::_cascade(int list)
+{
+	int32_t node = heads[list];
+	heads[list] = NONE;
+	if(node == NONE)
+	{
+		return;
+	}
+
+	/* break the ring first, _link rewrites prev/next as it goes */
+	nodes[nodes[node].prev].next = NONE;
+	while(node != NONE)
+	{
+		int32_t next = nodes[node].next;
+		_link(node, _listFor(nodes[node].dueTick));
+		node = next;
+	}
+}
+
+bool ChunkTickQueue::schedule(const TilePos& pos, TileID tileId, uint32_t dueTick, uint32_t sequence)
+{
+	uint16_t localPos = _localPos(pos);
+	uint32_t key = _key(localPos, tileId);
+	if(index.find(key) != index.end())
+	{
+		return false;
+	}
+
+	if(dueTick <= cursor)
+	{
+		dueTick = cursor + 1;
+	}
+
+	int32_t node = _allocNode();
+	Node& entry = nodes[node];
+	entry.dueTick = dueTick;
+	entry.sequence = sequence;
+	entry.localPos = localPos;
+	entry.tileId = tileId;
+	_link(node, _listFor(dueTick));
+
+	index[key] = node;
+	return true;
+}
+
+bool ChunkTickQueue::cancel(const TilePos& pos, TileID tileId)
+{
+	auto it = index.find(_key(_localPos(pos), tileId));
+	if(it == index.end())
+	{
+		return false;
+	}
+
+	_unlink(it->second);
+	_freeNode(it->second);
+	index.erase(it);
+	return true;
+}
+
+bool ChunkTickQueue::isPending(const TilePos& pos, TileID tileId) const
+{
+	return index.find(_key(_localPos(pos), tileId)) != index.end();
+}
+
+void ChunkTickQueue::collectDue(uint32_t currentTick, std::vector<PendingTick>& out)
+{
+	while(cursor < currentTick && !index.empty())
+	{
+		cursor++;
+		if((cursor & ((1 << 20) - 1)) == 0)
+		{
+			_cascade(OVERFLOW_LIST);
+		}
+		if((cursor & ((1 << 14) - 1)) == 0)
+		{
+			_cascade(LEVEL2_BASE + ((cursor >> 14) & (LEVEL2_SLOTS - 1)));
+		}
+		if((cursor & (LEVEL0_SLOTS - 1)) == 0)
+		{
+			_cascade(LEVEL1_BASE + ((cursor >> 8) & (LEVEL1_SLOTS - 1)));
+		}
+
+		int list = cursor & (LEVEL0_SLOTS - 1);
+		while(heads[list] != NONE)
+		{
+			int32_t node = heads[list];
+			Node entry = nodes[node];
+			_unlink(node);
+			_freeNode(node);
+			index.erase(_key(entry.localPos, entry.tileId));
+
+			PendingTick tick;
+			tick.pos = _worldPos(entry.localPos);
+			tick.tileId = entry.tileId;
+			tick.dueTick = entry.dueTick;
+			tick.sequence = entry.sequence;
+			out.push_back(tick);
+		}
+	}
+
+	/* nothing pending, the wheel is empty and can jump straight to now */
+	if(cursor < currentTick)
+	{
+		cursor = currentTick;
+	}
+}
+
+void ChunkTickQueue::getPending(std::vector<PendingTick>& out) const
+{
+	for(auto& entry : index)
+	{
+		const Node& node = nodes[entry.second];
+		PendingTick tick;
+		tick.pos = _worldPos(node.localPos);
+		tick.tileId = node.tileId;
+		tick.dueTick = node.dueTick;
+		tick.sequence = node.sequence;
+		out.push_back(tick);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Pending scheduled tile ticks of one chunk, kept in a hierarchical timing wheel
+	Level 0 has a slot per tick for the next 256 ticks, levels 1 and 2 have 64 slots
+	each covering 256 and 16384 ticks and cascade down as time passes, anything
+	further sits in an overflow list. Insert, cancel and the same-position dedupe are
+	O(1); slots are FIFO so ticks due on the same tick keep their scheduling order.
+*/
+class ChunkTickQueue
+{
+public:
+	struct PendingTick
+	{
+		TilePos pos;
+		TileID tileId;
+		uint32_t dueTick;
+		uint32_t sequence; // scheduling order, ties between equal dueTick
+	};
+
+	ChunkTickQueue(int cx, int cz, uint32_t currentTick);
+
+	/* Returns false if the same tile is already pending at pos */
+	bool schedule(const TilePos&, TileID, uint32_t dueTick, uint32_t sequence);
+	bool cancel(const TilePos&, TileID);
+	bool isPending(const TilePos&, TileID) const;
+
+	/* Advances to currentTick, appending every tick that came due in order */
+	void collectDue(uint32_t currentTick, std::vector<PendingTick>&);
+
+	/* Everything still pending, for saving with the chunk */
+	void getPending(std::vector<PendingTick>&) const;
+
+	int size() const { return (int) index.size(); }
+	bool empty() const { return index.empty(); }
+
+private:
+	static const int LEVEL0_SLOTS = 256;
+	static const int LEVEL1_SLOTS = 64;
+	static const int LEVEL2_SLOTS = 64;
+	static const int LEVEL1_BASE = LEVEL0_SLOTS;
+	static const int LEVEL2_BASE = LEVEL1_BASE + LEVEL1_SLOTS;
+	static const int OVERFLOW_LIST = LEVEL2_BASE + LEVEL2_SLOTS;
+	static const int LIST_COUNT = OVERFLOW_LIST + 1;
+	static const int32_t NONE = -1;
+
+	struct Node
+	{
+		uint32_t dueTick;
+		uint32_t sequence;
+		uint16_t localPos;
+		TileID tileId;
+		int16_t list;
+		int32_t prev;
+		int32_t next;
+	};
+
+	int cx, cz;
+	uint32_t cursor; // last tick collected
+	int32_t heads[LIST_COUNT];
+	std::vector<Node> nodes;
+	int32_t freeList;
+	std::unordered_map<uint32_t, int32_t> index;
+
+	static uint16_t _localPos(const TilePos& pos)
+	{
+		return (uint16_t) (((pos.x & 15) << 11) | ((pos.z & 15) << 7) | (pos.y & 127));
+	}
+
+	/* 15-bit position over a full 16 bits of ID, so 16-bit tile states still fit */
+	static uint32_t _key(uint16_t localPos, TileID tileId)
+	{
+		return ((uint32_t) localPos << 16) | (uint16_t) tileId;
+	}
+
+	int _listFor(uint32_t dueTick) const;
+	void _link(int32_t, int);
+	void _unlink(int32_t);
+	void _cascade(int);
+	int32_t _allocNode();
+	void _freeNode(int32_t);
+	TilePos _worldPos(uint16_t) const;
+};
@@ -0,0 +1,184 @@
+#include "RandomTickScheduler.h"
+
+#include <algorithm>
+#include <memory>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+#include "world/level/tile/TileCapabilities.h"
+#include "world/level/tile/TileHookProfiler.h"
+#include "world/entity/item/ItemDropBatch.h"
+
+RandomTickScheduler::RandomTickScheduler()
+{
+	stats = Stats();
+}
+
+void RandomTickScheduler::onChunkLoaded(int cx, int cz, const TileID* blocks)
+{
+	ChunkCounts& counts = chunks[_key(cx, cz)];
+	counts.cx = cx;
+	counts.cz = cz;
+	for(int i = 0; i < SECTION_COUNT; i++)
+	{
+		counts.ticking[i] = 0;
+	}
+
+	for(int column = 0; column < 256; column++)
+	{
+		const TileID* ids = blocks + (column << 7);
+		for(int y = 0; y < 128; y++)
+		{
+			if(TileProperties::isTicking(ids[y]))
+			{
+				counts.ticking[y >> 4]++;
+			}
+		}
+	}
+}
+
+void RandomTickScheduler::onChunkUnloaded(int cx, int cz)
+{
+	chunks.erase(_key(cx, cz));
+}
+
+void RandomTickScheduler::onTileChanged(int x, int y, int z, TileID oldId, TileID newId)
+{
+	bool wasTicking = TileProperties::isTicking(oldId);
+	bool isTicking = TileProperties::isTicking(newId);
+	if(wasTicking == isTicking || y < 0 || y >= SECTION_COUNT * 16)
+	{
+		return;
+	}
+
+	auto it = chunks.find(_key(x >> 4, z >> 4));
+	if(it == chunks.end())
+	{
+		return;
+	}
+
+	uint16_t& count = it->second.ticking[y >> 4];
+	if(isTicking)
+	{
+		count++;
+	}
+	else if(count > 0)
+	{
+		count--;
+	}
+}
+
+int RandomTickScheduler::getTickingCount(int cx, int sectionY, int cz) const
+{
+	auto it = chunks.find(_key(cx, cz));
+	if(it == chunks.end() || sectionY < 0 || sectionY >= SECTION_COUNT)
+	{
+		return 0;
+	}
+
+	return it->second.ticking[sectionY];
+}
+
+uint32_t RandomTickScheduler::_sectionSeed(uint32_t seed, uint32_t tickCount, int cx, int sectionY, int cz)
+{
+	uint32_t hash = seed ^ (tickCount * 0x9E3779B9u);
+	hash ^= (uint32_t) cx * 0x85EBCA6Bu;
+	hash ^= (uint32_t) cz * 0xC2B2AE35u;
+	hash ^= (uint32_t) sectionY * 0x27D4EB2Fu;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+	return hash;
+}
+
+void RandomTickScheduler::_tickSection(TileSource& region, const SectionJob& section, uint32_t seed, uint32_t tickCount)
+{
+	uint32_t sectionSeed = _sectionSeed(seed, tickCount, section.cx, section.sectionY, section.cz);
+	uint32_t state = sectionSeed | 1;
+	int baseX = section.cx << 4;
+	int baseY = section.sectionY << 4;
+	int baseZ = section.cz << 4;
+	std::unique_ptr<Random> random;
+
+	for(int i = 0; i < TICKS_PER_SECTION; i++)
+	{
+		/* xorshift32, the tick itself gets its own Random */
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		int x = baseX + (state & 15);
+		int y = baseY + ((state >> 4) & 15);
+		int z = baseZ + ((state >> 8) & 15);
+
+		TileID blockId = region.getTile(x, y, z).blockId;
+		if(!TileProperties::isTicking(blockId))
+		{
+			stats.idleHits++;
+			continue;
+		}
+		if(!TileCapabilities::has(blockId, TileCapabilities::TICK))
+		{
+			stats.hooksSkipped++;
+			continue;
+		}
+
+		if(!random)
+		{
+			random.reset(new Random(sectionSeed));
+		}
+
+		{
+			TILE_HOOK_SCOPE(blockId, TICK);
+			Tile::tiles[blockId]->tick(&region, x, y, z, random.get());
+		}
+		stats.tilesTicked++;
+	}
+
+	stats.sectionsTicked++;
+}
+
+void RandomTickScheduler::tick(TileSource& region, uint32_t seed, uint32_t tickCount)
+{
+	stats = Stats();
+
+	/* sort so the tick order is stable between runs */
+	jobs.clear();
+	for(auto& entry : chunks)
+	{
+		const ChunkCounts& counts = entry.second;
+		for(int sectionY = 0; sectionY < SECTION_COUNT; sectionY++)
+		{
+			if(counts.ticking[sectionY] == 0)
+			{
+				stats.sectionsSkipped++;
+				continue;
+			}
+
+			SectionJob job = {counts.cx, sectionY, counts.cz};
+			jobs.push_back(job);
+		}
+	}
+
+	std::sort(jobs.begin(), jobs.end(), [](const SectionJob& a, const SectionJob& b)
+	{
+		if(a.cx != b.cx)
+		{
+			return a.cx < b.cx;
+		}
+		if(a.cz != b.cz)
+		{
+			return a.cz < b.cz;
+		}
+		return a.sectionY < b.sectionY;
+	});
+
+	/* decaying leaves drop saplings and apples by the forest, merge them into stacks */
+	ItemDropBatch::begin(region);
+	for(const SectionJob& job : jobs)
+	{
+		_tickSection(region, job, seed, tickCount);
+	}
+	ItemDropBatch::end();
+
+	TileCapabilities::addSkipped(TileCapabilities::TICK, stats.hooksSkipped);
+}
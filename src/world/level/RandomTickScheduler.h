@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Random tile ticks that only visit sections holding something that ticks
+	Every loaded chunk keeps a count of Tile::shouldTick[] tiles per 16-high section,
+	maintained on tile change, and sections at zero are skipped without a single lookup.
+	Each section draws its positions from a stream seeded by (seed, tick, position) and
+	the sections run in a sorted order, so a fixed seed gives the same ticks every run.
+	Everything runs on the calling thread: the ticks touch entities, scheduled ticks,
+	light and drops that aren't safe to share, and picking three positions per section
+	costs less than handing the sections to worker threads would.
+*/
+class RandomTickScheduler
+{
+public:
+	static const int SECTION_COUNT = 8; // 128 tiles high
+	static const int TICKS_PER_SECTION = 3;
+
+	struct Stats
+	{
+		int sectionsTicked;
+		int sectionsSkipped;
+		int tilesTicked;
+		int idleHits; // picked a position whose tile doesn't tick
+		int hooksSkipped; // ticking tile that doesn't override Tile::tick
+	};
+
+	RandomTickScheduler();
+
+	/* blocks is the chunk's ID array in LevelChunk order, (x << 11) | (z << 7) | y */
+	void onChunkLoaded(int cx, int cz, const TileID* blocks);
+	void onChunkUnloaded(int cx, int cz);
+	void onTileChanged(int x, int y, int z, TileID oldId, TileID newId);
+
+	int getTickingCount(int cx, int sectionY, int cz) const;
+
+	void tick(TileSource&, uint32_t seed, uint32_t tickCount);
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct ChunkCounts
+	{
+		int cx, cz;
+		uint16_t ticking[SECTION_COUNT];
+	};
+
+	struct SectionJob
+	{
+		int cx, sectionY, cz;
+	};
+
+	std::unordered_map<int64_t, ChunkCounts> chunks;
+	std::vector<SectionJob> jobs;
+	Stats stats;
+
+	static int64_t _key(int cx, int cz)
+	{
+		return ((int64_t) cx << 32) | (uint32_t) cz;
+	}
+
+	static uint32_t _sectionSeed(uint32_t seed, uint32_t tickCount, int cx, int sectionY, int cz);
+	void _tickSection(TileSource&, const SectionJob&, uint32_t, uint32_t);
+};
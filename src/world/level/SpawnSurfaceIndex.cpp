@@ -0,0 +1,282 @@
+#include "SpawnSurfaceIndex.h"
+
+#include <algorithm>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+
+bool SpawnSurfaceIndex::_isCandidate(TileID below, TileID at, TileID above)
+{
+	return TileProperties::isSolid(below) &&
+		!TileProperties::blocksMotion(at) && !TileProperties::isLiquid(at) &&
+		!TileProperties::blocksMotion(above) && !TileProperties::isLiquid(above);
+}
+
+SpawnSurfaceIndex::SpawnSurfaceIndex(int category)
+{
+	this->category = category;
+	stats = Stats();
+}
+
+/* Raw sky and block light, without the time of day */
+int SpawnSurfaceIndex::_lightBucket(TileSource& region, int list, const TilePos& pos)
+{
+	int sky = std::min(std::max((int) region.getBrightness(LightLayer::Sky, pos), 0), LIGHT_LEVELS - 1);
+	int block = std::min(std::max((int) region.getBrightness(LightLayer::Block, pos), 0), LIGHT_LEVELS - 1);
+	return _bucket(list, sky, block);
+}
+
+/* The block light values that land max(sky - skyDarken, block) in range, false if none */
+bool SpawnSurfaceIndex::_blockRange(int sky, int skyDarken, int minLight, int maxLight, int& minBlock, int& maxBlock)
+{
+	int light = std::max(sky - skyDarken, 0);
+	if(light > maxLight)
+	{
+		return false;
+	}
+
+	minBlock = (light >= minLight)? 0 : minLight;
+	maxBlock = maxLight;
+	return minBlock <= maxBlock;
+}
+
+SpawnSurfaceIndex::ChunkIndex* SpawnSurfaceIndex::_find(int cx, int cz)
+{
+	auto it = chunks.find(_chunkKey(cx, cz));
+	return it != chunks.end()? &it->second : NULL;
+}
+
+const SpawnSurfaceIndex::ChunkIndex* SpawnSurfaceIndex::_find(int cx, int cz) const
+{
+	auto it = chunks.find(_chunkKey(cx, cz));
+	return it != chunks.end()? &it->second : NULL;
+}
+
+void SpawnSurfaceIndex::onChunkLoaded(TileSource& region, int cx, int cz)
+{
+	ChunkIndex& chunk = chunks[_chunkKey(cx, cz)];
+	chunk.cx = cx;
+	chunk.cz = cz;
+	chunk.biomes.clear();
+	chunk.lists.clear();
+	chunk.buckets.clear();
+	chunk.slotOf.clear();
+
+	for(int x = 0; x < 16; x++)
+	{
+		for(int z = 0; z < 16; z++)
+		{
+			int worldX = (cx << 4) + x;
+			int worldZ = (cz << 4) + z;
+
+			/* the mob list only depends on the column, look it up once */
+			Biome* biome = region.getBiome(TilePos(worldX, 0, worldZ));
+			Biome::MobList* mobs = biome? &biome->getMobs(category) : NULL;
+			if(!mobs || mobs->empty())
+			{
+				chunk.columnList[(x << 4) | z] = NO_LIST;
+				continue;
+			}
+
+			int list = 0;
+			while(list < (int) chunk.lists.size() && chunk.lists[list] != mobs)
+			{
+				list++;
+			}
+			if(list == (int) chunk.lists.size())
+			{
+				chunk.lists.push_back(mobs);
+				chunk.biomes.push_back(biome);
+				chunk.buckets.resize(chunk.lists.size() * LIGHT_LEVELS * LIGHT_LEVELS);
+			}
+			chunk.columnList[(x << 4) | z] = (uint8_t) list;
+
+			/* walk up the column keeping the two tiles below in hand */
+			TileID below = 0;
+			TileID at = region.getTile(worldX, 0, worldZ).blockId;
+			for(int y = 0; y < HEIGHT - 1; y++)
+			{
+				TileID above = region.getTile(worldX, y + 1, worldZ).blockId;
+				if(y > 0 && _isCandidate(below, at, above))
+				{
+					TilePos pos(worldX, y, worldZ);
+					_insert(chunk, _local(x, y, z), _lightBucket(region, list, pos));
+				}
+				below = at;
+				at = above;
+			}
+		}
+	}
+}
+
+void SpawnSurfaceIndex::onChunkUnloaded(int cx, int cz)
+{
+	chunks.erase(_chunkKey(cx, cz));
+}
+
+void SpawnSurfaceIndex::_insert(ChunkIndex& chunk, uint16_t local, int bucket)
+{
+	std::vector<uint16_t>& list = chunk.buckets[bucket];
+	chunk.slotOf[local] = ((uint32_t) bucket << 16) | (uint32_t) list.size();
+	list.push_back(local);
+}
+
+/* Swap with the bucket's last entry so removal stays O(1) */
+void SpawnSurfaceIndex::_remove(ChunkIndex& chunk, uint16_t local)
+{
+	auto it = chunk.slotOf.find(local);
+	if(it == chunk.slotOf.end())
+	{
+		return;
+	}
+
+	std::vector<uint16_t>& list = chunk.buckets[it->second >> 16];
+	uint32_t slot = it->second & 0xFFFF;
+	uint16_t last = list.back();
+	list[slot] = last;
+	chunk.slotOf[last] = (it->second & 0xFFFF0000) | slot;
+	list.pop_back();
+	chunk.slotOf.erase(local);
+}
+
+void SpawnSurfaceIndex::_refresh(TileSource& region, ChunkIndex& chunk, int x, int y, int z)
+{
+	int list = chunk.columnList[((x & 15) << 4) | (z & 15)];
+	if(y <= 0 || y >= HEIGHT - 1 || list == NO_LIST)
+	{
+		return;
+	}
+
+	uint16_t local = _local(x, y, z);
+	_remove(chunk, local);
+
+	TileID below = region.getTile(x, y - 1, z).blockId;
+	TileID at = region.getTile(x, y, z).blockId;
+	TileID above = region.getTile(x, y + 1, z).blockId;
+	if(_isCandidate(below, at, above))
+	{
+		_insert(chunk, local, _lightBucket(region, list, TilePos(x, y, z)));
+	}
+}
+
+void SpawnSurfaceIndex::onTileChanged(TileSource& region, int x, int y, int z)
+{
+	ChunkIndex* chunk = _find(x >> 4, z >> 4);
+	if(!chunk)
+	{
+		return;
+	}
+
+	for(int dy = -1; dy <= 1; dy++)
+	{
+		_refresh(region, *chunk, x, y + dy, z);
+	}
+}
+
+void SpawnSurfaceIndex::onLightChanged(TileSource& region, int sx, int sy, int sz)
+{
+	ChunkIndex* chunk = _find(sx, sz);
+	if(!chunk)
+	{
+		return;
+	}
+
+	/* collect first, rebucketing while walking the buckets would visit entries twice */
+	std::vector<uint16_t> moved;
+	for(const auto& entry : chunk->slotOf)
+	{
+		if((entry.first & 127) >> 4 == sy)
+		{
+			moved.push_back(entry.first);
+		}
+	}
+
+	for(uint16_t local : moved)
+	{
+		int bucket = chunk->slotOf[local] >> 16;
+		TilePos pos((sx << 4) + (local >> 11), local & 127, (sz << 4) + ((local >> 7) & 15));
+		int moveTo = _lightBucket(region, bucket / (LIGHT_LEVELS * LIGHT_LEVELS), pos);
+		if(moveTo == bucket)
+		{
+			continue;
+		}
+
+		_remove(*chunk, local);
+		_insert(*chunk, local, moveTo);
+		stats.rebucketed++;
+	}
+}
+
+int SpawnSurfaceIndex::getCandidateCount(int cx, int cz, int minLight, int maxLight, int skyDarken) const
+{
+	const ChunkIndex* chunk = _find(cx, cz);
+	if(!chunk)
+	{
+		return 0;
+	}
+
+	int count = 0;
+	for(int list = 0; list < (int) chunk->lists.size(); list++)
+	{
+		for(int sky = 0; sky < LIGHT_LEVELS; sky++)
+		{
+			int minBlock, maxBlock;
+			if(!_blockRange(sky, skyDarken, minLight, maxLight, minBlock, maxBlock))
+			{
+				continue;
+			}
+			for(int block = minBlock; block <= maxBlock; block++)
+			{
+				count += chunk->buckets[_bucket(list, sky, block)].size();
+			}
+		}
+	}
+
+	return count;
+}
+
+bool SpawnSurfaceIndex::sample(int cx, int cz, int minLight, int maxLight, int skyDarken, Random& random, Candidate& out)
+{
+	stats.samples++;
+
+	minLight = minLight < 0? 0 : minLight;
+	maxLight = maxLight >= LIGHT_LEVELS? LIGHT_LEVELS - 1 : maxLight;
+	int count = getCandidateCount(cx, cz, minLight, maxLight, skyDarken);
+	if(count == 0)
+	{
+		stats.emptyChunks++;
+		return false;
+	}
+
+	ChunkIndex& chunk = *_find(cx, cz);
+	int pick = random.genrand_int32() % count;
+	for(int list = 0; list < (int) chunk.lists.size(); list++)
+	{
+		for(int sky = 0; sky < LIGHT_LEVELS; sky++)
+		{
+			int minBlock, maxBlock;
+			if(!_blockRange(sky, skyDarken, minLight, maxLight, minBlock, maxBlock))
+			{
+				continue;
+			}
+			for(int block = minBlock; block <= maxBlock; block++)
+			{
+				const std::vector<uint16_t>& bucket = chunk.buckets[_bucket(list, sky, block)];
+				if(pick >= (int) bucket.size())
+				{
+					pick -= bucket.size();
+					continue;
+				}
+
+				uint16_t local = bucket[pick];
+				out.pos = TilePos((cx << 4) + (local >> 11), local & 127, (cz << 4) + ((local >> 7) & 15));
+				out.light = std::max(std::max(sky - skyDarken, 0), block);
+				out.biome = chunk.biomes[list];
+				out.mobs = chunk.lists[list];
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
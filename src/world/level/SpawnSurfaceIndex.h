@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/* Per-chunk index of the positions a mob could spawn at
+	A position qualifies when the tile under it is solid and neither it nor the tile above
+	blocks motion or holds liquid, so the index only changes when one of those three tiles
+	does. Candidates are bucketed by the mob list of their column (Biome::getMobs for the
+	index's category, columns with an empty list are left out) and by their raw sky and
+	block light. The time of day only enters at query time, as the skyDarken the caller
+	passes in, so dusk and dawn don't touch the buckets. The spawner asks for a random
+	candidate within a light range and only runs Tile::getMobToSpawn on the tile under it,
+	instead of rolling random positions and paying getBrightness and getBiome for each miss.
+*/
+class SpawnSurfaceIndex
+{
+public:
+	static const int HEIGHT = 128;
+	static const int LIGHT_LEVELS = 16;
+
+	struct Candidate
+	{
+		TilePos pos;
+		int light; // with the skyDarken of the query applied
+		Biome* biome;
+		Biome::MobList* mobs;
+	};
+
+	struct Stats
+	{
+		int samples;
+		int emptyChunks; // nothing in the requested light range
+		int rebucketed;
+	};
+
+	/* category is passed to Biome::getMobs, one index per mob category */
+	SpawnSurfaceIndex(int category);
+
+	void onChunkLoaded(TileSource&, int cx, int cz);
+	void onChunkUnloaded(int cx, int cz);
+	/* x, y, z changed, the candidates at y - 1 .. y + 1 are checked again */
+	void onTileChanged(TileSource&, int x, int y, int z);
+	/* Light in the section changed, its candidates move to their new buckets */
+	void onLightChanged(TileSource&, int sx, int sy, int sz);
+	void onBiomeChanged(TileSource& region, int cx, int cz) { onChunkLoaded(region, cx, cz); }
+
+	int getCandidateCount(int cx, int cz, int minLight, int maxLight, int skyDarken) const;
+	/* Picks a uniformly random candidate with minLight <= max(sky - skyDarken, block) <= maxLight */
+	bool sample(int cx, int cz, int minLight, int maxLight, int skyDarken, Random&, Candidate& out);
+
+	const Stats& getStats() const { return stats; }
+	void resetStats() { stats = Stats(); }
+
+private:
+	static const uint8_t NO_LIST = 0xFF;
+
+	struct ChunkIndex
+	{
+		int cx, cz;
+		uint8_t columnList[256]; // index into lists, per (x << 4) | z, NO_LIST if nothing spawns there
+		std::vector<Biome*> biomes; // the first biome seen with each list
+		std::vector<Biome::MobList*> lists;
+		std::vector<std::vector<uint16_t>> buckets; // (list * 16 + sky) * 16 + block, local positions
+		std::unordered_map<uint16_t, uint32_t> slotOf; // local position to (bucket << 16) | slot
+	};
+
+	int category;
+	std::unordered_map<int64_t, ChunkIndex> chunks;
+	Stats stats;
+
+	static int64_t _chunkKey(int cx, int cz)
+	{
+		return ((int64_t) cx << 32) | (uint32_t) cz;
+	}
+
+	/* Same order as LevelChunk, (x << 11) | (z << 7) | y */
+	static uint16_t _local(int x, int y, int z)
+	{
+		return (uint16_t) (((x & 15) << 11) | ((z & 15) << 7) | y);
+	}
+
+	static int _bucket(int list, int sky, int block)
+	{
+		return (list * LIGHT_LEVELS + sky) * LIGHT_LEVELS + block;
+	}
+
+	static bool _isCandidate(TileID below, TileID at, TileID above);
+	static int _lightBucket(TileSource&, int list, const TilePos&);
+	static bool _blockRange(int sky, int skyDarken, int minLight, int maxLight, int& minBlock, int& maxBlock);
+	ChunkIndex* _find(int cx, int cz);
+	const ChunkIndex* _find(int cx, int cz) const;
+	void _insert(ChunkIndex&, uint16_t local, int bucket);
+	void _remove(ChunkIndex&, uint16_t local);
+	void _refresh(TileSource&, ChunkIndex&, int x, int y, int z);
+};
@@ -0,0 +1,152 @@
+#include "TileTickScheduler.h"
+
+#include <algorithm>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileCapabilities.h"
+#include "world/level/tile/TileHookProfiler.h"
+#include "world/entity/item/ItemDropBatch.h"
+
+static bool _dueOrder(const TileTickScheduler::PendingTick& a, const TileTickScheduler::PendingTick& b)
+{
+	if(a.dueTick != b.dueTick)
+	{
+		return a.dueTick < b.dueTick;
+	}
+	return a.sequence < b.sequence;
+}
+
+TileTickScheduler::TileTickScheduler()
+{
+	currentTick = 0;
+	sequence = 0;
+}
+
+ChunkTickQueue* TileTickScheduler::_getQueue(const TilePos& pos) const
+{
+	auto it = chunks.find(_key(pos.x >> 4, pos.z >> 4));
+	return (it != chunks.end())? it->second.get() : NULL;
+}
+
+bool TileTickScheduler::schedule(const TilePos& pos, TileID tileId)
+{
+	Tile* tile = Tile::tiles[tileId];
+	if(!tile)
+	{
+		return false;
+	}
+
+	return schedule(pos, tileId, tile->getTickDelay());
+}
+
+bool TileTickScheduler::schedule(const TilePos& pos, TileID tileId, int delay)
+{
+	ChunkTickQueue* queue = _getQueue(pos);
+	if(!queue)
+	{
+		return false;
+	}
+
+	return queue->schedule(pos, tileId, currentTick + (delay > 0? delay : 1), sequence++);
+}
+
+bool TileTickScheduler::cancel(const TilePos& pos, TileID tileId)
+{
+	ChunkTickQueue* queue = _getQueue(pos);
+	return queue && queue->cancel(pos, tileId);
+}
+
+bool TileTickScheduler::isPending(const TilePos& pos, TileID tileId) const
+{
+	ChunkTickQueue* queue = _getQueue(pos);
+	return queue && queue->isPending(pos, tileId);
+}
+
+void TileTickScheduler::onChunkLoaded(int cx, int cz, const std::vector<SavedTick>& saved)
+{
+	std::unique_ptr<ChunkTickQueue>& queue = chunks[_key(cx, cz)];
+	queue.reset(new ChunkTickQueue(cx, cz, currentTick));
+
+	for(const SavedTick& tick : saved)
+	{
+		queue->schedule(tick.pos, tick.tileId, currentTick + (tick.delay > 0? tick.delay : 1), sequence++);
+	}
+}
+
+void TileTickScheduler::onChunkUnloaded(int cx, int cz, std::vector<SavedTick>& out)
+{
+	auto it = chunks.find(_key(cx, cz));
+	if(it == chunks.end())
+	{
+		return;
+	}
+
+	std::vector<PendingTick> pending;
+	it->second->getPending(pending);
+	std::sort(pending.begin(), pending.end(), _dueOrder);
+
+	for(const PendingTick& tick : pending)
+	{
+		SavedTick saved;
+		saved.pos = tick.pos;
+		saved.tileId = tick.tileId;
+		saved.delay = (int) (tick.dueTick - currentTick);
+		out.push_back(saved);
+	}
+
+	chunks.erase(it);
+}
+
+int TileTickScheduler::tick(TileSource& region, uint32_t _currentTick, Random& random)
+{
+	currentTick = _currentTick;
+
+	due.clear();
+	for(auto& entry : chunks)
+	{
+		entry.second->collectDue(currentTick, due);
+	}
+	std::sort(due.begin(), due.end(), _dueOrder);
+
+	int dispatched = 0;
+	uint32_t skipped = 0;
+
+	/* scheduled ticks break tiles too (cactus, falling sand on torches), their drops go into one batch */
+	ItemDropBatch::begin(region);
+	for(const PendingTick& tick : due)
+	{
+		/* the tile may have been replaced since the tick was scheduled */
+		if(region.getTile(tick.pos.x, tick.pos.y, tick.pos.z).blockId != tick.tileId)
+		{
+			continue;
+		}
+
+		if(!TileCapabilities::has(tick.tileId, TileCapabilities::TICK))
+		{
+			skipped++;
+			continue;
+		}
+
+		{
+			TILE_HOOK_SCOPE(tick.tileId, TICK);
+			Tile::tiles[tick.tileId]->tick(&region, tick.pos.x, tick.pos.y, tick.pos.z, &random);
+		}
+		dispatched++;
+	}
+	ItemDropBatch::end();
+
+	TileCapabilities::addSkipped(TileCapabilities::TICK, skipped);
+
+	return dispatched;
+}
+
+int TileTickScheduler::getPendingCount() const
+{
+	int count = 0;
+	for(auto& entry : chunks)
+	{
+		count += entry.second->size();
+	}
+
+	return count;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ChunkTickQueue.h"
+
+/* Scheduled tile ticks (Tile::getTickDelay()) partitioned per chunk
+	Each loaded chunk owns a ChunkTickQueue, so unloading a chunk hands back its
+	pending ticks for serialisation and loading restores them, without touching any
+	global structure. Due ticks are dispatched in (due tick, scheduling order).
+*/
+class TileTickScheduler
+{
+public:
+	typedef ChunkTickQueue::PendingTick PendingTick;
+
+	/* Serialised form, delay is relative so it survives the level's tick counter */
+	struct SavedTick
+	{
+		TilePos pos;
+		TileID tileId;
+		int delay;
+	};
+
+	TileTickScheduler();
+
+	/* Uses Tile::getTickDelay() of tileId */
+	bool schedule(const TilePos&, TileID);
+	bool schedule(const TilePos&, TileID, int delay);
+	bool cancel(const TilePos&, TileID);
+	bool isPending(const TilePos&, TileID) const;
+
+	void onChunkLoaded(int cx, int cz, const std::vector<SavedTick>&);
+	/* Removes the chunk's queue, out receives what was still pending */
+	void onChunkUnloaded(int cx, int cz, std::vector<SavedTick>& out);
+
+	/* Runs every tick due by currentTick, returns how many were dispatched */
+	int tick(TileSource&, uint32_t currentTick, Random&);
+
+	uint32_t getCurrentTick() const { return currentTick; }
+	int getPendingCount() const;
+
+private:
+	std::unordered_map<int64_t, std::unique_ptr<ChunkTickQueue>> chunks;
+	std::vector<PendingTick> due;
+	uint32_t currentTick;
+	uint32_t sequence;
+
+	static int64_t _key(int cx, int cz)
+	{
+		return ((int64_t) cx << 32) | (uint32_t) cz;
+	}
+
+	ChunkTickQueue* _getQueue(const TilePos&) const;
+};
@@ -0,0 +1,125 @@
+#include "TileUpdateQueue.h"
+
+#include <algorithm>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileCapabilities.h"
+#include "world/level/tile/TileHookProfiler.h"
+#include "world/entity/item/ItemDropBatch.h"
+
+static const int NEIGHBOUR_OFFSET[6][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+
+size_t TileUpdateQueue::KeyHash::operator()(const Key& key) const
+{
+	size_t hash = (size_t) key.pos.x * 73856093u;
+	hash ^= (size_t) key.pos.y * 19349663u;
+	hash ^= (size_t) key.pos.z * 83492791u;
+	hash ^= ((size_t) (key.source.x - key.pos.x + 1) * 3 + (key.source.y - key.pos.y + 1)) * 3 + (key.source.z - key.pos.z + 1);
+	return hash;
+}
+
+TileUpdateQueue::TileUpdateQueue(int budget)
+{
+	setBudget(budget);
+	stats = Stats();
+	lastTick = Stats();
+	resetCounters();
+}
+
+void TileUpdateQueue::setBudget(int _budget)
+{
+	budget = (_budget < 1)? 1 : _budget;
+}
+
+void TileUpdateQueue::resetCounters()
+{
+	for(int i = 0; i < 256; i++)
+	{
+		generated[i] = 0;
+	}
+}
+
+bool TileUpdateQueue::push(const TilePos& pos, const TilePos& source, TileID sourceId)
+{
+	Key key = {pos, source};
+	if(!seen.insert(key).second)
+	{
+		stats.deduplicated++;
+		return false;
+	}
+
+	Update update = {pos, source, sourceId};
+	queue.push_back(update);
+	generated[sourceId]++;
+	stats.queued++;
+	return true;
+}
+
+void TileUpdateQueue::notifyNeighbors(const TilePos& pos, TileID sourceId)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		push(TilePos(pos.x + NEIGHBOUR_OFFSET[i][0], pos.y + NEIGHBOUR_OFFSET[i][1], pos.z + NEIGHBOUR_OFFSET[i][2]), pos, sourceId);
+	}
+}
+
+const TileUpdateQueue::Stats& TileUpdateQueue::tick(TileSource& region)
+{
+	int dispatched = 0;
+
+	/* a farm broken by water or a piston pops its crops here, one batch for the whole cascade */
+	ItemDropBatch::begin(region);
+
+	/* updates queued by the handlers land at the back, so this walks the cascade breadth first */
+	while(!queue.empty() && dispatched < budget)
+	{
+		Update update = queue.front();
+		queue.pop_front();
+
+		/* no longer pending, so the handler below may queue the same pair again */
+		Key key = {update.pos, update.source};
+		seen.erase(key);
+
+		TileID blockId = region.getTile(update.pos.x, update.pos.y, update.pos.z).blockId;
+		Tile* tile = Tile::tiles[blockId];
+		if(tile && !TileCapabilities::has(blockId, TileCapabilities::NEIGHBOR_CHANGED))
+		{
+			stats.hooksSkipped++;
+		}
+		else if(tile)
+		{
+			TILE_HOOK_SCOPE(blockId, NEIGHBOR_CHANGED);
+			tile->neighborChanged(&region, update.pos.x, update.pos.y, update.pos.z, update.source.x, update.source.y, update.source.z);
+		}
+		dispatched++;
+	}
+	ItemDropBatch::end();
+
+	stats.dispatched = dispatched;
+	stats.carriedOver = queue.size();
+	TileCapabilities::addSkipped(TileCapabilities::NEIGHBOR_CHANGED, stats.hooksSkipped);
+	lastTick = stats;
+	stats = Stats();
+	return lastTick;
+}
+
+void TileUpdateQueue::getTopSources(int n, std::vector<std::pair<TileID, uint64_t>>& out) const
+{
+	out.clear();
+	for(int i = 0; i < 256; i++)
+	{
+		if(generated[i])
+		{
+			out.push_back(std::make_pair((TileID) i, generated[i]));
+		}
+	}
+
+	std::sort(out.begin(), out.end(), [](const std::pair<TileID, uint64_t>& a, const std::pair<TileID, uint64_t>& b)
+	{
+		return a.second > b.second;
+	});
+	if((int) out.size() > n)
+	{
+		out.resize(n);
+	}
+}
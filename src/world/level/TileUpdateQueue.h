@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/* Breadth-first queue for Tile::neighborChanged notifications
+	A tile change queues its six neighbour notifications instead of calling them
+	recursively, so piston and sand cascades run iteratively. A (position, source) pair
+	is queued at most once while it is pending; once dispatched it can be queued again,
+	since the source may have changed since. At most 'budget' notifications run per tick
+	and the rest carry over to the next one.
+*/
+class TileUpdateQueue
+{
+public:
+	struct Update
+	{
+		TilePos pos;
+		TilePos source;
+		TileID sourceId;
+	};
+
+	struct Stats
+	{
+		int queued;
+		int deduplicated;
+		int dispatched;
+		int carriedOver;
+		int hooksSkipped; // tiles that don't override neighborChanged
+	};
+
+	TileUpdateQueue(int budget = 8192);
+
+	void setBudget(int);
+	int getBudget() const { return budget; }
+
+	/* Queues neighborChanged for the six tiles around pos, caused by sourceId at pos */
+	void notifyNeighbors(const TilePos& pos, TileID sourceId);
+	/* Returns false if the pair is already waiting in the queue */
+	bool push(const TilePos& pos, const TilePos& source, TileID sourceId);
+
+	/* Runs this tick's share of the queue, the stats cover everything since the last tick */
+	const Stats& tick(TileSource&);
+
+	size_t size() const { return queue.size(); }
+	const Stats& getLastTickStats() const { return lastTick; }
+
+	/* Updates generated per source tile ID since the last reset */
+	uint64_t getGeneratedCount(TileID sourceId) const { return generated[sourceId]; }
+	/* The n IDs that generated the most updates, highest first */
+	void getTopSources(int n, std::vector<std::pair<TileID, uint64_t>>&) const;
+	void resetCounters();
+
+private:
+	struct Key
+	{
+		TilePos pos;
+		TilePos source;
+
+		bool operator==(const Key& other) const
+		{
+			return pos.x == other.pos.x && pos.y == other.pos.y && pos.z == other.pos.z &&
+				source.x == other.source.x && source.y == other.source.y && source.z == other.source.z;
+		}
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key&) const;
+	};
+
+	std::deque<Update> queue;
+	std::unordered_set<Key, KeyHash> seen;
+	int budget;
+	Stats stats;
+	Stats lastTick;
+	uint64_t generated[256];
+};
@@ -0,0 +1,117 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int threadCount)
+{
+	this->threadCount = 1;
+	job = NULL;
+	workers = 0;
+	remaining = 0;
+	generation = 0;
+	stopping = false;
+	setThreadCount(threadCount);
+}
+
+WorkerPool::~WorkerPool()
+{
+	_stop();
+}
+
+void WorkerPool::setThreadCount(int _threadCount)
+{
+	_threadCount = (_threadCount < 1)? 1 : _threadCount;
+	if(_threadCount == threadCount && (int) threads.size() == threadCount - 1)
+	{
+		return;
+	}
+
+	_stop();
+	threadCount = _threadCount;
+	_start();
+}
+
+void WorkerPool::_start()
+{
+	stopping = false;
+	for(int w = 1; w < threadCount; w++)
+	{
+		threads.push_back(std::thread(&WorkerPool::_workerLoop, this, w, generation));
+	}
+}
+
+void WorkerPool::_stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for(std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	threads.clear();
+}
+
+/* seen starts at the generation the thread was created in, so it doesn't pick up the last run again */
+void WorkerPool::_workerLoop(int worker, unsigned int seen)
+{
+	while(true)
+	{
+		const Job* current;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return stopping || generation != seen; });
+			if(stopping)
+			{
+				return;
+			}
+
+			seen = generation;
+			if(worker >= workers)
+			{
+				continue;
+			}
+			current = job;
+		}
+
+		(*current)(worker);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if(--remaining == 0)
+		{
+			done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::run(int _workers, const Job& _job)
+{
+	if(_workers > threadCount)
+	{
+		_workers = threadCount;
+	}
+	if(_workers <= 1)
+	{
+		if(_workers == 1)
+		{
+			_job(0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		job = &_job;
+		workers = _workers;
+		remaining = _workers - 1;
+		generation++;
+	}
+	wake.notify_all();
+
+	_job(0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	done.wait(lock, [&]() { return remaining == 0; });
+	job = NULL;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Threads started once and handed one job at a time
+	run() calls the job with every worker index, worker 0 on the calling thread, and
+	returns once all of them are done; the other threads sleep between runs instead of
+	being started and joined every time.
+*/
+class WorkerPool
+{
+public:
+	typedef std::function<void(int worker)> Job;
+
+	WorkerPool(int threadCount = 1);
+	~WorkerPool();
+
+	/* Only takes effect between runs */
+	void setThreadCount(int);
+	int getThreadCount() const { return threadCount; }
+
+	/* Calls job(0) .. job(workers - 1), workers is capped at the thread count */
+	void run(int workers, const Job& job);
+
+private:
+	int threadCount;
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	const Job* job;
+	int workers;
+	int remaining;
+	unsigned int generation;
+	bool stopping;
+
+	void _start();
+	void _stop();
+	void _workerLoop(int worker, unsigned int seen);
+};
@@ -0,0 +1,208 @@
+#include "BiomeTintCache.h"
+
+#include <vector>
+
+BiomeTintCache::BiomeTintCache(int radius)
+{
+	computed = 0;
+	setRadius(radius);
+}
+
+BiomeTintCache::~BiomeTintCache()
+{
+	clear();
+}
+
+void BiomeTintCache::setRadius(int _radius)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	radius = _radius < 0? 0 : (_radius > MAX_RADIUS? MAX_RADIUS : _radius);
+	for(auto it = chunks.begin(); it != chunks.end();)
+	{
+		_drop(it++);
+	}
+}
+
+/* Views already handed out keep their colours, they only learn they are out of date */
+void BiomeTintCache::_drop(std::unordered_map<int64_t, std::shared_ptr<ChunkTint>>::iterator it)
+{
+	it->second->stale.store(true, std::memory_order_relaxed);
+	chunks.erase(it);
+}
+
+uint32_t BiomeTintCache::_sample(Biome* biome, const TilePos& pos, TintClass tint)
+{
+	switch(tint)
+	{
+	case GRASS:
+		return biome->getGrassColor(pos);
+	case FOLIAGE:
+		return biome->getFoliageColor(pos);
+	default:
+		return biome->waterColor;
+	}
+}
+
+/* Running sums along x for every row of the padded area, then along z per column,
+	three channels at once; each column costs two adds and two subtracts per pass
+	whatever the radius
+*/
+void BiomeTintCache::_compute(TileSource& region, int cx, int cz, ChunkTint& chunk)
+{
+	int side = 16 + radius * 2;
+	int baseX = (cx << 4) - radius;
+	int baseZ = (cz << 4) - radius;
+	int window = radius * 2 + 1;
+	int area = window * window;
+
+	std::vector<Biome*> biomes(side * side);
+	for(int z = 0; z < side; z++)
+	{
+		for(int x = 0; x < side; x++)
+		{
+			biomes[z * side + x] = region.getBiome(TilePos(baseX + x, 0, baseZ + z));
+		}
+	}
+
+	std::vector<uint32_t> samples(side * side);
+	std::vector<uint32_t> rows(side * 16 * 3);
+	for(int tint = 0; tint < TINT_CLASS_COUNT; tint++)
+	{
+		for(int z = 0; z < side; z++)
+		{
+			for(int x = 0; x < side; x++)
+			{
+				samples[z * side + x] = _sample(biomes[z * side + x], TilePos(baseX + x, 0, baseZ + z), (TintClass) tint);
+			}
+		}
+
+		for(int z = 0; z < side; z++)
+		{
+			uint32_t sum[3] = {0, 0, 0};
+			for(int x = 0; x < side; x++)
+			{
+				uint32_t color = samples[z * side + x];
+				sum[0] += (color >> 16) & 0xFF;
+				sum[1] += (color >> 8) & 0xFF;
+				sum[2] += color & 0xFF;
+
+				if(x >= window)
+				{
+					uint32_t old = samples[z * side + x - window];
+					sum[0] -= (old >> 16) & 0xFF;
+					sum[1] -= (old >> 8) & 0xFF;
+					sum[2] -= old & 0xFF;
+				}
+
+				if(x >= window - 1)
+				{
+					uint32_t* out = &rows[(z * 16 + x - (window - 1)) * 3];
+					out[0] = sum[0];
+					out[1] = sum[1];
+					out[2] = sum[2];
+				}
+			}
+		}
+
+		for(int x = 0; x < 16; x++)
+		{
+			uint32_t sum[3] = {0, 0, 0};
+			for(int z = 0; z < side; z++)
+			{
+				const uint32_t* in = &rows[(z * 16 + x) * 3];
+				sum[0] += in[0];
+				sum[1] += in[1];
+				sum[2] += in[2];
+
+				if(z >= window)
+				{
+					const uint32_t* old = &rows[((z - window) * 16 + x) * 3];
+					sum[0] -= old[0];
+					sum[1] -= old[1];
+					sum[2] -= old[2];
+				}
+
+				if(z >= window - 1)
+				{
+					int column = ((z - (window - 1)) << 4) | x;
+					chunk.colors[tint][column] = 0xFF000000 | ((sum[0] / area) << 16) | ((sum[1] / area) << 8) | (sum[2] / area);
+				}
+			}
+		}
+	}
+
+	chunk.cx = cx;
+	chunk.cz = cz;
+	chunk.stale.store(false, std::memory_order_relaxed);
+	computed.fetch_add(1, std::memory_order_relaxed);
+}
+
+BiomeTintCache::View BiomeTintCache::getView(TileSource& region, int cx, int cz)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::shared_ptr<ChunkTint>& chunk = chunks[_key(cx, cz)];
+	if(!chunk)
+	{
+		chunk = std::make_shared<ChunkTint>();
+		_compute(region, cx, cz, *chunk);
+	}
+
+	return chunk;
+}
+
+/* Neighbouring blocks are nearly always in the same chunk, so each thread keeps the view it used last */
+uint32_t BiomeTintCache::getColor(TileSource& region, int x, int z, TintClass tint)
+{
+	static thread_local const BiomeTintCache* lastCache = NULL;
+	static thread_local View last;
+
+	if(lastCache != this || !last || last->cx != (x >> 4) || last->cz != (z >> 4) || last->isStale())
+	{
+		last = getView(region, x >> 4, z >> 4);
+		lastCache = this;
+	}
+
+	return last->getColor(x, z, tint);
+}
+
+void BiomeTintCache::onBiomeChanged(int cx, int cz)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	/* a chunk's blend reads up to radius columns into its neighbours */
+	int reach = (radius + 15) >> 4;
+	for(int dx = -reach; dx <= reach; dx++)
+	{
+		for(int dz = -reach; dz <= reach; dz++)
+		{
+			auto it = chunks.find(_key(cx + dx, cz + dz));
+			if(it != chunks.end())
+			{
+				_drop(it);
+			}
+		}
+	}
+}
+
+void BiomeTintCache::onChunkUnloaded(int cx, int cz)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = chunks.find(_key(cx, cz));
+	if(it != chunks.end())
+	{
+		_drop(it);
+	}
+}
+
+void BiomeTintCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for(auto it = chunks.begin(); it != chunks.end();)
+	{
+		_drop(it++);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/* Blended biome colours per column, per chunk
+	Grass, foliage and water tints are averaged over a (2 * radius + 1)^2 square of
+	columns. A chunk's 16x16 result is computed once with a separable box filter, a
+	running sum along x then along z over the chunk plus its border, and kept until the
+	biome data of the chunk or of a neighbour within the radius changes, or a neighbour
+	loads and its real biomes replace what the border was blended with, so getColor
+	during meshing is a table read.
+
+	A computed chunk is immutable and handed out as a View, a shared_ptr the mesher takes
+	once per chunk with getView() and reads without locking. Invalidating or unloading
+	only drops the cache's reference and marks the old view stale, so a view still being
+	meshed stays readable until its holder lets go. getColor() keeps the last view per
+	thread, so only crossing into another chunk takes the lock.
+*/
+class BiomeTintCache
+{
+public:
+	enum TintClass
+	{
+		GRASS,
+		FOLIAGE,
+		WATER,
+		TINT_CLASS_COUNT
+	};
+
+	static const int MAX_RADIUS = 8;
+
+	struct ChunkTint
+	{
+		int cx, cz;
+		uint32_t colors[TINT_CLASS_COUNT][256]; // indexed (z << 4) | x
+		mutable std::atomic<bool> stale; // the cache has dropped it, ask for a new view
+
+		uint32_t getColor(int x, int z, TintClass tint) const { return colors[tint][((z & 15) << 4) | (x & 15)]; }
+		bool isStale() const { return stale.load(std::memory_order_relaxed); }
+	};
+
+	typedef std::shared_ptr<const ChunkTint> View;
+
+	BiomeTintCache(int radius = 1);
+	~BiomeTintCache();
+
+	void setRadius(int);
+	int getRadius() const { return radius; }
+
+	/* Computes the chunk if needed, the view stays valid for as long as it is held */
+	View getView(TileSource&, int cx, int cz);
+	uint32_t getColor(TileSource&, int x, int z, TintClass);
+
+	/* Biomes of the chunk changed, its blend and the neighbours' that reach into it are stale */
+	void onBiomeChanged(int cx, int cz);
+	/* The neighbours blended this chunk's columns in before they existed, they are stale */
+	void onChunkLoaded(int cx, int cz) { onBiomeChanged(cx, cz); }
+	void onChunkUnloaded(int cx, int cz);
+	void clear();
+
+	int getComputedCount() const { return computed.load(std::memory_order_relaxed); }
+
+private:
+	std::unordered_map<int64_t, std::shared_ptr<ChunkTint>> chunks;
+	std::mutex mutex;
+	int radius;
+	std::atomic<int> computed;
+
+	static int64_t _key(int cx, int cz)
+	{
+		return ((int64_t) cx << 32) | (uint32_t) cz;
+	}
+
+	void _compute(TileSource&, int cx, int cz, ChunkTint&);
+	void _drop(std::unordered_map<int64_t, std::shared_ptr<ChunkTint>>::iterator);
+	static uint32_t _sample(Biome*, const TilePos&, TintClass);
+};
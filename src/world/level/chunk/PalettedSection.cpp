@@ -0,0 +1,360 @@
+#include "PalettedSection.h"
+
+#include <cstring>
+#include <unordered_map>
+
+PalettedSection::PalettedSection()
+{
+	fill(0);
+}
+
+PalettedSection::PalettedSection(State state)
+{
+	fill(state);
+}
+
+void PalettedSection::fill(State state)
+{
+	palette.assign(1, state);
+	words.clear();
+	words.shrink_to_fit();
+	bits = 0;
+}
+
+int PalettedSection::_bitsFor(int paletteSize)
+{
+	if(paletteSize <= 1)
+	{
+		return 0;
+	}
+	if(paletteSize <= 2)
+	{
+		return 1;
+	}
+	if(paletteSize <= 4)
+	{
+		return 2;
+	}
+	if(paletteSize <= 16)
+	{
+		return 4;
+	}
+	if(paletteSize <= 256)
+	{
+		return 8;
+	}
+	return 16;
+}
+
+PalettedSection::State PalettedSection::get(int index) const
+{
+	return bits? palette[_getIndex(index)] : palette[0];
+}
+
+/* Palettes are a handful of states in practice, a scan beats hashing */
+int PalettedSection::_find(State state) const
+{
+	for(int i = 0; i < (int) palette.size(); i++)
+	{
+		if(palette[i] == state)
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+int PalettedSection::_add(State state)
+{
+	palette.push_back(state);
+	int needed = _bitsFor(palette.size());
+	if(needed != bits)
+	{
+		_resize(needed);
+	}
+
+	return palette.size() - 1;
+}
+
+void PalettedSection::_resize(int newBits)
+{
+	uint16_t indices[VOLUME];
+	for(int i = 0; i < VOLUME; i++)
+	{
+		indices[i] = bits? (uint16_t) _getIndex(i) : 0;
+	}
+
+	bits = newBits;
+	if(!bits)
+	{
+		words.clear();
+		words.shrink_to_fit();
+		return;
+	}
+
+	words.assign(VOLUME * bits / 64, 0);
+	for(int i = 0; i < VOLUME; i++)
+	{
+		_setIndex(i, indices[i]);
+	}
+}
+
+void PalettedSection::set(int index, State state)
+{
+	if(get(index) == state)
+	{
+		return;
+	}
+
+	int paletteIndex = _find(state);
+	if(paletteIndex < 0)
+	{
+		/* as many states as positions, drop the dead ones before growing */
+		if((int) palette.size() >= VOLUME && !compact())
+		{
+			/* all live means each state is used once, the one being overwritten can hold the new one */
+			palette[_getIndex(index)] = state;
+			return;
+		}
+		paletteIndex = _add(state);
+	}
+
+	_setIndex(index, paletteIndex);
+}
+
+bool PalettedSection::compact()
+{
+	if(!bits)
+	{
+		return false;
+	}
+
+	std::vector<int> used(palette.size(), 0);
+	for(int i = 0; i < VOLUME; i++)
+	{
+		used[_getIndex(i)]++;
+	}
+
+	std::vector<State> newPalette;
+	std::vector<uint16_t> remap(palette.size(), 0);
+	for(int i = 0; i < (int) palette.size(); i++)
+	{
+		if(used[i])
+		{
+			remap[i] = newPalette.size();
+			newPalette.push_back(palette[i]);
+		}
+	}
+
+	if(newPalette.size() == palette.size())
+	{
+		return false;
+	}
+
+	uint16_t indices[VOLUME];
+	for(int i = 0; i < VOLUME; i++)
+	{
+		indices[i] = remap[_getIndex(i)];
+	}
+
+	palette.swap(newPalette);
+	palette.shrink_to_fit();
+	bits = _bitsFor(palette.size());
+	if(!bits)
+	{
+		words.clear();
+		words.shrink_to_fit();
+		return true;
+	}
+
+	words.assign(VOLUME * bits / 64, 0);
+	words.shrink_to_fit();
+	for(int i = 0; i < VOLUME; i++)
+	{
+		_setIndex(i, indices[i]);
+	}
+
+	return true;
+}
+
+size_t PalettedSection::getMemoryUsage() const
+{
+	return sizeof(*this) + palette.capacity() * sizeof(State) + words.capacity() * sizeof(uint64_t);
+}
+
+/* One word at a time with the width known at compile time, no division per entry */
+template<int BITS, typename T>
+void PalettedSection::_unpack(T* out, const T* lookup) const
+{
+	const int perWord = 64 / BITS;
+	const uint64_t mask = ((uint64_t) 1 << BITS) - 1;
+	for(size_t w = 0; w < words.size(); w++)
+	{
+		uint64_t word = words[w];
+		for(int i = 0; i < perWord; i++)
+		{
+			*out++ = lookup[word & mask];
+			word >>= BITS;
+		}
+	}
+}
+
+template<typename T>
+void PalettedSection::_decode(T* out, const T* lookup) const
+{
+	switch(bits)
+	{
+	case 0:
+		for(int i = 0; i < VOLUME; i++)
+		{
+			out[i] = lookup[0];
+		}
+		break;
+	case 1:
+		_unpack<1>(out, lookup);
+		break;
+	case 2:
+		_unpack<2>(out, lookup);
+		break;
+	case 4:
+		_unpack<4>(out, lookup);
+		break;
+	case 8:
+		_unpack<8>(out, lookup);
+		break;
+	default:
+		_unpack<16>(out, lookup);
+		break;
+	}
+}
+
+void PalettedSection::decode(State* out) const
+{
+	_decode(out, palette.data());
+}
+
+void PalettedSection::decodeIds(uint16_t* out) const
+{
+	std::vector<uint16_t> lookup(palette.size());
+	for(size_t i = 0; i < palette.size(); i++)
+	{
+		lookup[i] = getStateId(palette[i]);
+	}
+
+	_decode(out, lookup.data());
+}
+
+/* The engine's tables stop at 255, anything above decodes as air until they grow */
+bool PalettedSection::fitsLegacy() const
+{
+	bool wide = false;
+	for(State state : palette)
+	{
+		wide |= getStateId(state) > 255;
+	}
+	if(!wide)
+	{
+		return true;
+	}
+
+	/* the palette may still hold states nothing uses since the last compact() */
+	uint16_t ids[VOLUME];
+	decodeIds(ids);
+	for(int i = 0; i < VOLUME; i++)
+	{
+		if(ids[i] > 255)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool PalettedSection::decodeTileIds(TileID* out) const
+{
+	if(!fitsLegacy())
+	{
+		return false;
+	}
+
+	std::vector<TileID> lookup(palette.size());
+	for(size_t i = 0; i < palette.size(); i++)
+	{
+		lookup[i] = (TileID) getStateId(palette[i]); // wide states left here are unused
+	}
+
+	_decode(out, lookup.data());
+	return true;
+}
+
+void PalettedSection::importLegacy(const TileID* blocks, const uint8_t* data, int sectionY)
+{
+	std::unordered_map<State, uint16_t> indexOf;
+	uint16_t indices[VOLUME];
+	palette.clear();
+
+	for(int y = 0; y < 16; y++)
+	{
+		for(int z = 0; z < 16; z++)
+		{
+			for(int x = 0; x < 16; x++)
+			{
+				int legacy = (x << 11) | (z << 7) | (sectionY << 4) | y;
+				uint8_t nibble = (legacy & 1)? (data[legacy >> 1] >> 4) : (data[legacy >> 1] & 15);
+				State state = makeState(blocks[legacy], nibble);
+
+				auto it = indexOf.find(state);
+				if(it == indexOf.end())
+				{
+					it = indexOf.insert(std::make_pair(state, (uint16_t) palette.size())).first;
+					palette.push_back(state);
+				}
+				indices[index(x, y, z)] = it->second;
+			}
+		}
+	}
+
+	bits = _bitsFor(palette.size());
+	words.assign(bits? VOLUME * bits / 64 : 0, 0);
+	words.shrink_to_fit();
+	if(bits)
+	{
+		for(int i = 0; i < VOLUME; i++)
+		{
+			_setIndex(i, indices[i]);
+		}
+	}
+}
+
+bool PalettedSection::exportLegacy(TileID* blocks, uint8_t* data, int sectionY) const
+{
+	if(!fitsLegacy())
+	{
+		return false;
+	}
+
+	State states[VOLUME];
+	decode(states);
+
+	for(int y = 0; y < 16; y++)
+	{
+		for(int z = 0; z < 16; z++)
+		{
+			for(int x = 0; x < 16; x++)
+			{
+				State state = states[index(x, y, z)];
+				uint16_t id = getStateId(state);
+				int legacy = (x << 11) | (z << 7) | (sectionY << 4) | y;
+				blocks[legacy] = (TileID) id;
+
+				uint8_t& pair = data[legacy >> 1];
+				uint8_t nibble = getStateData(state);
+				pair = (legacy & 1)? (uint8_t) ((pair & 0x0F) | (nibble << 4)) : (uint8_t) ((pair & 0xF0) | nibble);
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/* A 16x16x16 section stored as a palette of (ID, data) states plus packed indices
+	States are 16-bit IDs with a data nibble, so the storage doesn't care that Tile::tiles
+	still stops at 255. Indices use 0, 1, 2, 4, 8 or 16 bits so none straddles a word; a
+	section of a single state (all air, all stone) keeps no index words at all. The palette
+	only grows on set(), compact() drops states no longer used and narrows the indices.
+
+	Positions are ordered like LightSection, (y << 8) | (z << 4) | x, and the decode
+	functions unpack a whole section per call for the mesher and the light engine.
+*/
+class PalettedSection
+{
+public:
+	static const int VOLUME = 16 * 16 * 16;
+
+	typedef uint32_t State; // (id << 4) | data
+
+	static State makeState(uint16_t id, uint8_t data) { return ((State) id << 4) | (data & 15); }
+	static uint16_t getStateId(State state) { return (uint16_t) (state >> 4); }
+	static uint8_t getStateData(State state) { return (uint8_t) (state & 15); }
+	static int index(int x, int y, int z) { return ((y & 15) << 8) | ((z & 15) << 4) | (x & 15); }
+
+	PalettedSection();
+	explicit PalettedSection(State fill);
+
+	State get(int index) const;
+	State get(int x, int y, int z) const { return get(index(x, y, z)); }
+	uint16_t getId(int x, int y, int z) const { return getStateId(get(x, y, z)); }
+	uint8_t getData(int x, int y, int z) const { return getStateData(get(x, y, z)); }
+
+	void set(int index, State);
+	void set(int x, int y, int z, uint16_t id, uint8_t data) { set(index(x, y, z), makeState(id, data)); }
+	void fill(State);
+
+	/* Drops unused states and narrows the indices, returns true if anything shrank */
+	bool compact();
+
+	bool isUniform() const { return bits == 0; }
+	int getBits() const { return bits; }
+	int getPaletteSize() const { return palette.size(); }
+	size_t getMemoryUsage() const;
+
+	/* Whole-section unpacking, out holds VOLUME entries */
+	void decode(State* out) const;
+	void decodeIds(uint16_t* out) const;
+	/* IDs for the 8-bit engine paths (LightEngine::loadSection, meshing); returns false and
+		writes nothing if the section holds an ID above 255, use decodeIds() then
+	*/
+	bool decodeTileIds(TileID* out) const;
+	/* Whether every state fits the 8-bit ID arrays */
+	bool fitsLegacy() const;
+
+	/* From and to LevelChunk's arrays, (x << 11) | (z << 7) | y IDs and data nibbles;
+		exportLegacy() refuses, leaving the arrays untouched, rather than write an ID above
+		255 as air
+	*/
+	void importLegacy(const TileID* blocks, const uint8_t* data, int sectionY);
+	bool exportLegacy(TileID* blocks, uint8_t* data, int sectionY) const;
+
+private:
+	std::vector<State> palette;
+	std::vector<uint64_t> words;
+	int bits;
+
+	int _find(State) const;
+	int _add(State);
+	void _resize(int newBits);
+	static int _bitsFor(int paletteSize);
+
+	uint32_t _getIndex(int index) const
+	{
+		int perWord = 64 / bits;
+		return (uint32_t) (words[index / perWord] >> ((index % perWord) * bits)) & ((1u << bits) - 1);
+	}
+
+	void _setIndex(int index, uint32_t value)
+	{
+		int perWord = 64 / bits;
+		int shift = (index % perWord) * bits;
+		uint64_t mask = (((uint64_t) 1 << bits) - 1) << shift;
+		uint64_t& word = words[index / perWord];
+		word = (word & ~mask) | ((uint64_t) value << shift);
+	}
+
+	/* lookup maps palette index to the value written out */
+	template<int BITS, typename T>
+	void _unpack(T* out, const T* lookup) const;
+	template<typename T>
+	void _decode(T* out, const T* lookup) const;
+};
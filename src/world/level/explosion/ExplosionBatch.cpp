@@ -0,0 +1,380 @@
+#include "ExplosionBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+#include "world/level/tile/TileCapabilities.h"
+#include "world/level/tile/TileHookProfiler.h"
+#include "world/level/light/LightEngine.h"
+#include "world/level/TileUpdateQueue.h"
+#include "world/entity/item/ItemDropBatch.h"
+
+static const float STEP = 0.3F;
+static const float STEP_DECAY = 0.22500001F;
+
+static const int NEIGHBOUR_OFFSET[6][3] = {
+	{0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}
+};
+
+float ExplosionBatch::directions[RAY_COUNT][3];
+bool ExplosionBatch::directionsBuilt = false;
+
+ExplosionBatch::ExplosionBatch(LightEngine* lightEngine, TileUpdateQueue* updateQueue)
+{
+	this->lightEngine = lightEngine;
+	this->updateQueue = updateQueue;
+	stats = Stats();
+	lastCommit = Stats();
+}
+
+/* Unit vectors towards every cell on the surface of the 16^3 grid, as Explosion::explode */
+void ExplosionBatch::_buildDirections()
+{
+	int count = 0;
+	for(int x = 0; x < GRID; x++)
+	{
+		for(int y = 0; y < GRID; y++)
+		{
+			for(int z = 0; z < GRID; z++)
+			{
+				if(x != 0 && x != GRID - 1 && y != 0 && y != GRID - 1 && z != 0 && z != GRID - 1)
+				{
+					continue;
+				}
+
+				float dx = x / (GRID - 1.0F) * 2.0F - 1.0F;
+				float dy = y / (GRID - 1.0F) * 2.0F - 1.0F;
+				float dz = z / (GRID - 1.0F) * 2.0F - 1.0F;
+				float length = sqrtf(dx * dx + dy * dy + dz * dz);
+				directions[count][0] = dx / length;
+				directions[count][1] = dy / length;
+				directions[count][2] = dz / length;
+				count++;
+			}
+		}
+	}
+
+	directionsBuilt = true;
+}
+
+float ExplosionBatch::_nextFloat(Random& random)
+{
+	return (random.genrand_int32() >> 8) * (1.0F / 16777216.0F);
+}
+
+int ExplosionBatch::add(TileSource& region, const Vec3& center, float radius, Random& random)
+{
+	if(!directionsBuilt)
+	{
+		_buildDirections();
+	}
+
+	/* a ray starts at no more than 1.3 * radius and loses at least 0.225 per step */
+	int extent = (int) ceilf(radius * 1.3F / STEP_DECAY * STEP) + 1;
+	int side = extent * 2 + 1;
+	int ox = (int) floorf(center.x) - extent;
+	int oy = (int) floorf(center.y) - extent;
+	int oz = (int) floorf(center.z) - extent;
+	bool dense = side <= MAX_DENSE_SIDE;
+	if(dense)
+	{
+		area.assign(side * side * side, -1);
+		marked.assign(area.size(), false);
+	}
+	else
+	{
+		sparseArea.clear();
+		sparseMarked.clear();
+	}
+
+	auto fetch = [&](int64_t cell) -> TileID
+	{
+		int cx = (int) (cell % side);
+		int cz = (int) ((cell / side) % side);
+		int cy = (int) (cell / ((int64_t) side * side));
+		stats.fetches++;
+		return region.getTile(ox + cx, oy + cy, oz + cz).blockId;
+	};
+
+	int alive = RAY_COUNT;
+	for(int i = 0; i < RAY_COUNT; i++)
+	{
+		rays.x[i] = center.x;
+		rays.y[i] = center.y;
+		rays.z[i] = center.z;
+		rays.dx[i] = directions[i][0] * STEP;
+		rays.dy[i] = directions[i][1] * STEP;
+		rays.dz[i] = directions[i][2] * STEP;
+		rays.power[i] = radius * (0.7F + _nextFloat(random) * 0.6F);
+	}
+
+	while(alive > 0)
+	{
+		/* cell of every ray, no lookups so this loop vectorizes */
+		for(int i = 0; i < alive; i++)
+		{
+			int cx = std::min(std::max((int) floorf(rays.x[i]) - ox, 0), side - 1);
+			int cy = std::min(std::max((int) floorf(rays.y[i]) - oy, 0), side - 1);
+			int cz = std::min(std::max((int) floorf(rays.z[i]) - oz, 0), side - 1);
+			rays.cell[i] = ((int64_t) cy * side + cz) * side + cx;
+		}
+
+		/* gather, each tile of the area is read from the region once */
+		for(int i = 0; i < alive; i++)
+		{
+			int64_t cell = rays.cell[i];
+			TileID blockId;
+			if(dense)
+			{
+				if(area[cell] < 0)
+				{
+					area[cell] = fetch(cell);
+				}
+				blockId = (TileID) area[cell];
+			}
+			else
+			{
+				auto it = sparseArea.find(cell);
+				if(it == sparseArea.end())
+				{
+					it = sparseArea.insert(std::make_pair(cell, fetch(cell))).first;
+				}
+				blockId = it->second;
+			}
+			rays.resistance[i] = blockId? (TileProperties::getExplosionResistance(blockId) + STEP) * STEP : 0.0F;
+		}
+
+		for(int i = 0; i < alive; i++)
+		{
+			rays.power[i] -= rays.resistance[i];
+		}
+
+		for(int i = 0; i < alive; i++)
+		{
+			if(rays.power[i] > 0.0F && rays.resistance[i] > 0.0F)
+			{
+				if(dense)
+				{
+					marked[rays.cell[i]] = true;
+				}
+				else
+				{
+					sparseMarked.insert(rays.cell[i]);
+				}
+			}
+		}
+
+		for(int i = 0; i < alive; i++)
+		{
+			rays.x[i] += rays.dx[i];
+			rays.y[i] += rays.dy[i];
+			rays.z[i] += rays.dz[i];
+			rays.power[i] -= STEP_DECAY;
+		}
+
+		stats.samples += alive;
+
+		/* move spent rays past the end so the loops above stay dense */
+		for(int i = 0; i < alive;)
+		{
+			if(rays.power[i] > 0.0F)
+			{
+				i++;
+				continue;
+			}
+
+			alive--;
+			rays.x[i] = rays.x[alive];
+			rays.y[i] = rays.y[alive];
+			rays.z[i] = rays.z[alive];
+			rays.dx[i] = rays.dx[alive];
+			rays.dy[i] = rays.dy[alive];
+			rays.dz[i] = rays.dz[alive];
+			rays.power[i] = rays.power[alive];
+		}
+	}
+
+	int added = 0;
+	auto addCell = [&](int64_t cell)
+	{
+		int x = ox + (int) (cell % side);
+		int z = oz + (int) ((cell / side) % side);
+		int y = oy + (int) (cell / ((int64_t) side * side));
+		if(destroyedAt.find(_key(x, y, z)) != destroyedAt.end())
+		{
+			return;
+		}
+
+		destroyedAt[_key(x, y, z)] = destroyed.size();
+		Target target = {TilePos(x, y, z), 1.0F / radius};
+		destroyed.push_back(target);
+		added++;
+	};
+
+	if(dense)
+	{
+		for(int cell = 0; cell < (int) marked.size(); cell++)
+		{
+			if(marked[cell])
+			{
+				addCell(cell);
+			}
+		}
+	}
+	else
+	{
+		for(int64_t cell : sparseMarked)
+		{
+			addCell(cell);
+		}
+		sparseArea.clear();
+		sparseMarked.clear();
+	}
+
+	stats.explosions++;
+	stats.rays += RAY_COUNT;
+	return added;
+}
+
+/* Only tiles next to the crater hear about it, the ones inside are gone */
+void ExplosionBatch::_notifyBorder(const TilePos& pos, TileID sourceId)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		TilePos neighbor(pos.x + NEIGHBOUR_OFFSET[i][0], pos.y + NEIGHBOUR_OFFSET[i][1], pos.z + NEIGHBOUR_OFFSET[i][2]);
+		if(destroyedAt.find(_key(neighbor.x, neighbor.y, neighbor.z)) != destroyedAt.end())
+		{
+			continue;
+		}
+
+		if(updateQueue)
+		{
+			updateQueue->push(neighbor, pos, sourceId);
+		}
+		else
+		{
+			neighbors.push_back(neighbor);
+			neighborSources.push_back(pos);
+		}
+	}
+}
+
+const ExplosionBatch::Stats& ExplosionBatch::commit(TileSource& region, const RemeshCallback& remesh)
+{
+	/* section order, so the edits walk each section's storage in one go */
+	std::sort(destroyed.begin(), destroyed.end(), [](const Target& a, const Target& b)
+	{
+		int64_t sectionA = LightEngine::sectionKey(a.pos.x >> 4, a.pos.y >> 4, a.pos.z >> 4);
+		int64_t sectionB = LightEngine::sectionKey(b.pos.x >> 4, b.pos.y >> 4, b.pos.z >> 4);
+		if(sectionA != sectionB)
+		{
+			return sectionA < sectionB;
+		}
+		return _key(a.pos.x, a.pos.y, a.pos.z) < _key(b.pos.x, b.pos.y, b.pos.z);
+	});
+
+	std::unordered_set<int64_t> sections;
+	neighbors.clear();
+	neighborSources.clear();
+
+	/* a crater drops a lot of the same cobblestone and dirt, merge it before spawning */
+	ItemDropBatch::begin(region);
+	for(const Target& target : destroyed)
+	{
+		const TilePos& pos = target.pos;
+		FullTile tile = region.getTileAndData(pos);
+		if(!tile.blockId)
+		{
+			continue;
+		}
+
+		Tile* destroyedTile = Tile::tiles[tile.blockId];
+		if(destroyedTile)
+		{
+			destroyedTile->spawnResources(&region, pos.x, pos.y, pos.z, tile.data, target.dropChance);
+		}
+
+		/* setTileNoUpdate skips onRemove, chests and furnaces still have to spill their contents */
+		if(destroyedTile && TileCapabilities::has(tile.blockId, TileCapabilities::ON_REMOVE))
+		{
+			TILE_HOOK_SCOPE(tile.blockId, ON_REMOVE);
+			destroyedTile->onRemove(&region, pos.x, pos.y, pos.z);
+		}
+
+		region.setTileNoUpdate(pos.x, pos.y, pos.z, 0);
+
+		if(destroyedTile)
+		{
+			destroyedTile->wasExploded(&region, pos.x, pos.y, pos.z);
+		}
+
+		if(lightEngine)
+		{
+			lightEngine->onTileChanged(pos.x, pos.y, pos.z, tile.blockId, 0);
+		}
+
+		/* a tile on a section border also uncovers faces in the section next to it */
+		for(int i = 0; i < 7; i++)
+		{
+			int x = pos.x, y = pos.y, z = pos.z;
+			if(i < 6)
+			{
+				x += NEIGHBOUR_OFFSET[i][0];
+				y += NEIGHBOUR_OFFSET[i][1];
+				z += NEIGHBOUR_OFFSET[i][2];
+			}
+			sections.insert(LightEngine::sectionKey(x >> 4, y >> 4, z >> 4));
+		}
+
+		_notifyBorder(pos, tile.blockId);
+		stats.destroyed++;
+	}
+	ItemDropBatch::end();
+
+	if(lightEngine && lightEngine->hasPendingChanges())
+	{
+		lightEngine->flush();
+		for(int64_t key : lightEngine->getRelitSections())
+		{
+			sections.insert(key);
+		}
+	}
+
+	/* without a queue the border is notified directly, still once per pair */
+	for(size_t i = 0; i < neighbors.size(); i++)
+	{
+		const TilePos& pos = neighbors[i];
+		TileID blockId = region.getTile(pos.x, pos.y, pos.z).blockId;
+		Tile* tile = Tile::tiles[blockId];
+		if(tile)
+		{
+			TILE_HOOK_SCOPE(blockId, NEIGHBOR_CHANGED);
+			const TilePos& source = neighborSources[i];
+			tile->neighborChanged(&region, pos.x, pos.y, pos.z, source.x, source.y, source.z);
+		}
+	}
+
+	if(remesh)
+	{
+		for(int64_t key : sections)
+		{
+			/* unpack LightEngine::sectionKey, sign extending each field */
+			int sx = (int) (key >> 38);
+			int sz = (int) ((int64_t) ((uint64_t) key << 26) >> 38);
+			int sy = (int) ((int64_t) ((uint64_t) key << 52) >> 52);
+			remesh(sx, sy, sz);
+		}
+	}
+
+	stats.remeshed += sections.size();
+	destroyed.clear();
+	destroyedAt.clear();
+	neighbors.clear();
+	neighborSources.clear();
+
+	lastCommit = stats;
+	stats = Stats();
+	return lastCommit;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class LightEngine;
+class TileUpdateQueue;
+
+/* Explosions gathered over a tick and applied in one pass
+	add() marches the 1352 rays of an explosion together, structure of arrays, with the
+	resistance read from TileProperties and every tile of the blast area fetched from the
+	region once. commit() then destroys the union of all blasts: drops, onRemove and
+	wasExploded per tile, the tiles cleared without updates, neighbour notifications only
+	for the tiles around the crater, one LightEngine flush and one remesh call per section.
+*/
+class ExplosionBatch
+{
+public:
+	typedef std::function<void(int sx, int sy, int sz)> RemeshCallback;
+
+	static const int GRID = 16; // rays go through the surface of a 16^3 grid
+	static const int RAY_COUNT = 1352;
+	/* blast areas up to this side (radius 12) are cached in flat arrays, bigger ones in hash maps */
+	static const int MAX_DENSE_SIDE = 48;
+
+	struct Stats
+	{
+		int explosions;
+		int rays;
+		int samples;
+		int fetches; // tiles read from the region
+		int destroyed;
+		int remeshed;
+	};
+
+	ExplosionBatch(LightEngine* lightEngine = NULL, TileUpdateQueue* updateQueue = NULL);
+
+	/* Traces the rays of an explosion at center, the tiles it breaks join the batch */
+	int add(TileSource&, const Vec3& center, float radius, Random&);
+	/* Destroys every queued tile and resets the batch */
+	const Stats& commit(TileSource&, const RemeshCallback&);
+
+	bool isEmpty() const { return destroyed.empty(); }
+	int size() const { return destroyed.size(); }
+	/* Everything added and committed by the last commit() */
+	const Stats& getLastCommitStats() const { return lastCommit; }
+
+private:
+	struct Target
+	{
+		TilePos pos;
+		float dropChance; // 1 / radius of the first explosion that reached it
+	};
+
+	/* One explosion's rays, lane i of every array is ray i */
+	struct Rays
+	{
+		float x[RAY_COUNT], y[RAY_COUNT], z[RAY_COUNT];
+		float dx[RAY_COUNT], dy[RAY_COUNT], dz[RAY_COUNT];
+		float power[RAY_COUNT];
+		int64_t cell[RAY_COUNT];
+		float resistance[RAY_COUNT];
+	};
+
+	static float directions[RAY_COUNT][3];
+	static bool directionsBuilt;
+
+	LightEngine* lightEngine;
+	TileUpdateQueue* updateQueue;
+	std::vector<Target> destroyed;
+	std::unordered_map<uint64_t, int> destroyedAt;
+	std::vector<int16_t> area; // blast area cache, -1 until fetched
+	std::vector<bool> marked;
+	std::unordered_map<int64_t, TileID> sparseArea; // the same past MAX_DENSE_SIDE
+	std::unordered_set<int64_t> sparseMarked;
+	std::vector<TilePos> neighbors, neighborSources; // border notifications when there's no queue
+	Rays rays;
+	Stats stats;
+	Stats lastCommit;
+
+	static void _buildDirections();
+	static uint64_t _key(int x, int y, int z)
+	{
+		return ((uint64_t) (x & 0x3FFFFFF) << 38) | ((uint64_t) (z & 0x3FFFFFF) << 12) | (uint64_t) (y & 0xFFF);
+	}
+
+	static float _nextFloat(Random&);
+	void _notifyBorder(const TilePos&, TileID);
+};
@@ -0,0 +1,358 @@
+#include "LightEngine.h"
+
+#include <algorithm>
+
+#include "world/level/tile/TileProperties.h"
+
+static const int NEIGHBOUR_OFFSET[6][3] = {{0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}};
+
+LightEngine::LightEngine(int threadCount)
+	: pool(threadCount)
+{
+	stats = Stats();
+}
+
+void LightEngine::setThreadCount(int threadCount)
+{
+	pool.setThreadCount(threadCount);
+}
+
+/* Every step costs at least one level, opaque tiles (lightBlock 255) stop light outright */
+int LightEngine::_attenuation(TileID blockId)
+{
+	int lightBlock = TileProperties::getLightBlock(blockId);
+	return (lightBlock < 1)? 1 : lightBlock;
+}
+
+void LightEngine::loadSection(int sx, int sy, int sz, const TileID* ids, const uint8_t* light)
+{
+	std::unique_ptr<LightSection>& section = sections[sectionKey(sx, sy, sz)];
+	section.reset(new LightSection());
+	memcpy(section->ids, ids, sizeof(section->ids));
+	if(light)
+	{
+		memcpy(section->light, light, sizeof(section->light));
+	}
+}
+
+void LightEngine::unloadSection(int sx, int sy, int sz)
+{
+	sections.erase(sectionKey(sx, sy, sz));
+}
+
+const LightSection* LightEngine::getSection(int sx, int sy, int sz) const
+{
+	auto it = sections.find(sectionKey(sx, sy, sz));
+	return (it != sections.end())? it->second.get() : NULL;
+}
+
+LightSection* LightEngine::_find(int x, int y, int z) const
+{
+	auto it = sections.find(sectionKey(x >> 4, y >> 4, z >> 4));
+	return (it != sections.end())? it->second.get() : NULL;
+}
+
+int LightEngine::getLight(int x, int y, int z) const
+{
+	LightSection* section = _find(x, y, z);
+	return section? section->getLight(LightSection::index(x, y, z)) : 0;
+}
+
+void LightEngine::onTileChanged(int x, int y, int z, TileID oldId, TileID newId)
+{
+	LightSection* section = _find(x, y, z);
+	if(!section)
+	{
+		return;
+	}
+
+	section->ids[LightSection::index(x, y, z)] = newId;
+	if(TileProperties::getLightBlock(oldId) != TileProperties::getLightBlock(newId) ||
+		TileProperties::getLightEmission(oldId) != TileProperties::getLightEmission(newId))
+	{
+		changes.push_back(TilePos(x, y, z));
+	}
+}
+
+LightEngine::SectionWork* LightEngine::_work(std::unordered_map<int64_t, SectionWork>& work, int x, int y, int z)
+{
+	int sx = x >> 4, sy = y >> 4, sz = z >> 4;
+	int64_t key = sectionKey(sx, sy, sz);
+
+	auto it = work.find(key);
+	if(it != work.end())
+	{
+		return &it->second;
+	}
+
+	auto section = sections.find(key);
+	if(section == sections.end())
+	{
+		return NULL; // unloaded, the light stops at the edge of the world
+	}
+
+	SectionWork& entry = work[key];
+	entry.key = key;
+	entry.section = section->second.get();
+	entry.sx = sx;
+	entry.sy = sy;
+	entry.sz = sz;
+	entry.relit = false;
+	return &entry;
+}
+
+void LightEngine::_push(std::unordered_map<int64_t, SectionWork>& work, const Step& step)
+{
+	SectionWork* entry = _work(work, step.x, step.y, step.z);
+	if(entry)
+	{
+		entry->inbox.push_back(step);
+	}
+}
+
+void LightEngine::_addSource(std::unordered_map<int64_t, SectionWork>& work, const TilePos& pos)
+{
+	SectionWork* entry = _work(work, pos.x, pos.y, pos.z);
+	if(entry)
+	{
+		entry->sources.push_back(pos);
+	}
+}
+
+/* Runs before any worker starts, so reading across sections is still safe here */
+void LightEngine::_seed(const TilePos& pos, std::unordered_map<int64_t, SectionWork>& work)
+{
+	LightSection* section = _find(pos.x, pos.y, pos.z);
+	if(!section)
+	{
+		return;
+	}
+
+	int index = LightSection::index(pos.x, pos.y, pos.z);
+	int oldLevel = section->getLight(index);
+	int emission = TileProperties::getLightEmission(section->ids[index]);
+	section->setLight(index, emission);
+
+	if(emission > 0)
+	{
+		_addSource(work, pos);
+	}
+
+	for(int i = 0; i < 6; i++)
+	{
+		TilePos neighbour(pos.x + NEIGHBOUR_OFFSET[i][0], pos.y + NEIGHBOUR_OFFSET[i][1], pos.z + NEIGHBOUR_OFFSET[i][2]);
+		if(oldLevel > 0)
+		{
+			Step step = {neighbour.x, neighbour.y, neighbour.z, pos, (uint8_t) oldLevel, DECREASE};
+			_push(work, step);
+		}
+		else
+		{
+			/* a tile that was dark may now let its neighbours' light through */
+			_addSource(work, neighbour);
+		}
+	}
+
+	if(oldLevel != emission)
+	{
+		relit.push_back(sectionKey(pos.x >> 4, pos.y >> 4, pos.z >> 4));
+	}
+}
+
+/* Clears what was lit through the removed light; cells lit by something else, or
+	emitting themselves, become sources for the increase pass
+*/
+void LightEngine::_decrease(SectionWork& work, std::vector<Step>& outbox, int& steps)
+{
+	LightSection& section = *work.section;
+	int minX = work.sx << 4, minY = work.sy << 4, minZ = work.sz << 4;
+
+	std::vector<Step> queue;
+	queue.swap(work.inbox);
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		Step step = queue[i];
+		steps++;
+		int index = LightSection::index(step.x, step.y, step.z);
+		int level = section.getLight(index);
+		if(level == 0)
+		{
+			continue;
+		}
+
+		TilePos pos(step.x, step.y, step.z);
+		if(level >= step.level)
+		{
+			work.sources.push_back(pos);
+			continue;
+		}
+
+		section.setLight(index, 0);
+		work.relit = true;
+		for(int n = 0; n < 6; n++)
+		{
+			Step next = {pos.x + NEIGHBOUR_OFFSET[n][0], pos.y + NEIGHBOUR_OFFSET[n][1], pos.z + NEIGHBOUR_OFFSET[n][2], pos, (uint8_t) level, DECREASE};
+			bool inside = (unsigned) (next.x - minX) < 16 && (unsigned) (next.y - minY) < 16 && (unsigned) (next.z - minZ) < 16;
+			(inside? queue : outbox).push_back(next);
+		}
+
+		int emission = TileProperties::getLightEmission(section.ids[index]);
+		if(emission > 0)
+		{
+			section.setLight(index, emission);
+			work.sources.push_back(pos);
+		}
+	}
+}
+
+/* Spreads from the collected sources and from steps handed over by other sections */
+void LightEngine::_increase(SectionWork& work, std::vector<Step>& outbox, int& steps)
+{
+	LightSection& section = *work.section;
+	int minX = work.sx << 4, minY = work.sy << 4, minZ = work.sz << 4;
+	auto inside = [&](int x, int y, int z)
+	{
+		return (unsigned) (x - minX) < 16 && (unsigned) (y - minY) < 16 && (unsigned) (z - minZ) < 16;
+	};
+
+	std::vector<Step> queue;
+	queue.swap(work.inbox);
+	auto spread = [&](const TilePos& from, int level)
+	{
+		for(int n = 0; n < 6; n++)
+		{
+			Step next = {from.x + NEIGHBOUR_OFFSET[n][0], from.y + NEIGHBOUR_OFFSET[n][1], from.z + NEIGHBOUR_OFFSET[n][2], from, (uint8_t) level, INCREASE};
+			(inside(next.x, next.y, next.z)? queue : outbox).push_back(next);
+		}
+	};
+
+	for(const TilePos& source : work.sources)
+	{
+		int level = section.getLight(LightSection::index(source.x, source.y, source.z));
+		if(level > 1)
+		{
+			spread(source, level);
+		}
+	}
+	work.sources.clear();
+
+	for(size_t i = 0; i < queue.size(); i++)
+	{
+		Step step = queue[i];
+		steps++;
+
+		/* whatever the source holds now, not what it held when the step was made */
+		int sourceLevel = step.level;
+		if(inside(step.source.x, step.source.y, step.source.z))
+		{
+			sourceLevel = section.getLight(LightSection::index(step.source.x, step.source.y, step.source.z));
+		}
+
+		int index = LightSection::index(step.x, step.y, step.z);
+		int level = sourceLevel - _attenuation(section.ids[index]);
+		if(level <= section.getLight(index))
+		{
+			continue;
+		}
+
+		section.setLight(index, level);
+		work.relit = true;
+		spread(TilePos(step.x, step.y, step.z), level);
+	}
+}
+
+void LightEngine::_runRounds(std::unordered_map<int64_t, SectionWork>& work, StepType type)
+{
+	std::vector<SectionWork*> active;
+	for(;;)
+	{
+		active.clear();
+		for(auto& entry : work)
+		{
+			if(!entry.second.inbox.empty() || (type == INCREASE && !entry.second.sources.empty()))
+			{
+				active.push_back(&entry.second);
+			}
+		}
+		if(active.empty())
+		{
+			break;
+		}
+
+		/* a stable order keeps the split between workers the same for the same input */
+		std::sort(active.begin(), active.end(), [](const SectionWork* a, const SectionWork* b)
+		{
+			return a->key < b->key;
+		});
+
+		stats.rounds++;
+		int workers = std::min(pool.getThreadCount(), (int) active.size());
+		std::vector<std::vector<Step>> outboxes(workers);
+		std::vector<int> steps(workers, 0);
+		pool.run(workers, [&](int worker)
+		{
+			for(size_t i = worker; i < active.size(); i += workers)
+			{
+				if(type == DECREASE)
+				{
+					_decrease(*active[i], outboxes[worker], steps[worker]);
+				}
+				else
+				{
+					_increase(*active[i], outboxes[worker], steps[worker]);
+				}
+			}
+		});
+
+		/* border handoff, merged on this thread so inboxes are never shared; with every
+			worker stopped an increase can read its source in the section it left
+		*/
+		for(int w = 0; w < workers; w++)
+		{
+			stats.steps += steps[w];
+			for(Step& step : outboxes[w])
+			{
+				if(step.type == INCREASE)
+				{
+					step.level = getLight(step.source.x, step.source.y, step.source.z);
+				}
+				_push(work, step);
+			}
+		}
+	}
+}
+
+const LightEngine::Stats& LightEngine::flush()
+{
+	stats = Stats();
+	relit.clear();
+	if(changes.empty())
+	{
+		return stats;
+	}
+
+	stats.changes = changes.size();
+	std::unordered_map<int64_t, SectionWork> work;
+	for(const TilePos& pos : changes)
+	{
+		_seed(pos, work);
+	}
+	changes.clear();
+
+	/* every removal everywhere before any light spreads again */
+	_runRounds(work, DECREASE);
+	_runRounds(work, INCREASE);
+
+	for(auto& entry : work)
+	{
+		if(entry.second.relit)
+		{
+			relit.push_back(entry.first);
+		}
+	}
+	std::sort(relit.begin(), relit.end());
+	relit.erase(std::unique(relit.begin(), relit.end()), relit.end());
+
+	stats.relitSections = relit.size();
+	return stats;
+}
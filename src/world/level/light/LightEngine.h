@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "LightSection.h"
+#include "world/level/WorkerPool.h"
+
+/* Batched block light propagation
+	Tile changes that affect lightBlock[] or lightEmission[] are only recorded;
+	flush() relights them all at once with the two-queue BFS: every removal runs to
+	completion first, collecting the cells still lit by something else as sources, and
+	only then do the increases spread from those sources, re-reading each source's level
+	when its step is processed so a source cleared after it was collected lights nothing.
+	Both passes run per section on a WorkerPool. A fill that reaches a section border
+	hands the step to the neighbouring section's inbox for the next round, so every
+	section is touched by exactly one worker per round and rounds run until no inbox is
+	left.
+*/
+class LightEngine
+{
+public:
+	struct Stats
+	{
+		int changes;
+		int rounds;
+		int steps;
+		int relitSections;
+	};
+
+	LightEngine(int threadCount = 1);
+
+	/* ids and light are 4096 IDs and 2048 nibble pairs, light may be NULL */
+	void loadSection(int sx, int sy, int sz, const TileID* ids, const uint8_t* light);
+	void unloadSection(int sx, int sy, int sz);
+	const LightSection* getSection(int sx, int sy, int sz) const;
+
+	void onTileChanged(int x, int y, int z, TileID oldId, TileID newId);
+	int getLight(int x, int y, int z) const;
+
+	bool hasPendingChanges() const { return !changes.empty(); }
+	/* Relights everything queued since the last flush */
+	const Stats& flush();
+
+	const Stats& getStats() const { return stats; }
+	/* Sections whose light changed during the last flush, for remeshing */
+	const std::vector<int64_t>& getRelitSections() const { return relit; }
+	void setThreadCount(int);
+
+	static int64_t sectionKey(int sx, int sy, int sz)
+	{
+		return ((int64_t) (sx & 0x3FFFFFF) << 38) | ((int64_t) (sz & 0x3FFFFFF) << 12) | (sy & 0xFFF);
+	}
+
+private:
+	enum StepType : uint8_t
+	{
+		DECREASE,
+		INCREASE
+	};
+
+	/* Propagation into x, y, z from the neighbouring cell source
+		A decrease carries the level source had before it was cleared. An increase reads
+		source again when it runs; level only stands in for it when source is in another
+		section, refreshed as the step crosses over between rounds
+	*/
+	struct Step
+	{
+		int x, y, z;
+		TilePos source;
+		uint8_t level;
+		StepType type;
+	};
+
+	struct SectionWork
+	{
+		int64_t key;
+		LightSection* section;
+		int sx, sy, sz;
+		std::vector<Step> inbox;
+		std::vector<TilePos> sources; // cells to spread from once the removals are done
+		bool relit;
+	};
+
+	std::unordered_map<int64_t, std::unique_ptr<LightSection>> sections;
+	std::vector<TilePos> changes;
+	std::vector<int64_t> relit;
+	WorkerPool pool;
+	Stats stats;
+
+	LightSection* _find(int x, int y, int z) const;
+	SectionWork* _work(std::unordered_map<int64_t, SectionWork>&, int x, int y, int z);
+	void _seed(const TilePos&, std::unordered_map<int64_t, SectionWork>&);
+	void _push(std::unordered_map<int64_t, SectionWork>&, const Step&);
+	void _addSource(std::unordered_map<int64_t, SectionWork>&, const TilePos&);
+	void _decrease(SectionWork&, std::vector<Step>& outbox, int& steps);
+	void _increase(SectionWork&, std::vector<Step>& outbox, int& steps);
+	void _runRounds(std::unordered_map<int64_t, SectionWork>&, StepType);
+	static int _attenuation(TileID);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/* 16x16x16 block light nibbles plus a copy of the section's tile IDs
+	The light engine only ever touches its own sections during a flush,
+	so workers never read TileSource or another worker's data.
+*/
+class LightSection
+{
+public:
+	static const int VOLUME = 16 * 16 * 16;
+
+	TileID ids[VOLUME];
+	uint8_t light[VOLUME / 2];
+
+	LightSection()
+	{
+		memset(ids, 0, sizeof(ids));
+		memset(light, 0, sizeof(light));
+	}
+
+	static int index(int x, int y, int z)
+	{
+		return ((y & 15) << 8) | ((z & 15) << 4) | (x & 15);
+	}
+
+	int getLight(int index) const
+	{
+		uint8_t pair = light[index >> 1];
+		return (index & 1)? (pair >> 4) : (pair & 15);
+	}
+
+	void setLight(int index, int level)
+	{
+		uint8_t& pair = light[index >> 1];
+		pair = (index & 1)? (uint8_t) ((pair & 0x0F) | (level << 4)) : (uint8_t) ((pair & 0xF0) | level);
+	}
+};
@@ -0,0 +1,733 @@
+#include "RedstoneCircuit.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileHookProfiler.h"
+
+static const int NEIGHBOUR_OFFSET[6][3] = {{0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}};
+/* dust also climbs one tile up or down along its four sides */
+static const int WIRE_STEP_OFFSET[8][3] = {{1, 1, 0}, {-1, 1, 0}, {0, 1, 1}, {0, 1, -1}, {1, -1, 0}, {-1, -1, 0}, {0, -1, 1}, {0, -1, -1}};
+
+static TilePos _offset(const TilePos& pos, const int* offset)
+{
+	return TilePos(pos.x + offset[0], pos.y + offset[1], pos.z + offset[2]);
+}
+
+static bool _samePos(const TilePos& a, const TilePos& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool RedstoneCircuit::enabled = false;
+
+RedstoneCircuit::RedstoneCircuit()
+{
+	tick = 0;
+	dirty = false;
+}
+
+void RedstoneCircuit::setEnabled(bool _enabled)
+{
+	enabled = _enabled;
+}
+
+bool RedstoneCircuit::isEnabled()
+{
+	return enabled;
+}
+
+bool RedstoneCircuit::isRedstoneTile(TileID blockId)
+{
+	Tile* tile = Tile::tiles[blockId];
+	if(!tile)
+	{
+		return false;
+	}
+
+	return tile == Tile::redStoneDust ||
+		tile == Tile::notGate_on || tile == Tile::notGate_off ||
+		tile == Tile::diode_on || tile == Tile::diode_off ||
+		tile->isSignalSource();
+}
+
+RedstoneCircuit::NodeType RedstoneCircuit::_classify(TileID blockId)
+{
+	Tile* tile = Tile::tiles[blockId];
+	if(tile == Tile::redStoneDust)
+	{
+		return WIRE;
+	}
+	if(tile == Tile::notGate_on || tile == Tile::notGate_off)
+	{
+		return NOT_GATE;
+	}
+	if(tile == Tile::diode_on || tile == Tile::diode_off)
+	{
+		return DIODE;
+	}
+	if(tile == Tile::lever || tile == Tile::button || tile == Tile::pressurePlate_stone || tile == Tile::pressurePlate_wood)
+	{
+		return SOURCE;
+	}
+	if(!isRedstoneTile(blockId))
+	{
+		return BLOCK;
+	}
+
+	return POLLED;
+}
+
+/* Torch data 1-4 hangs off the side of the tile at -x, +x, -z, +z, 5 stands on the tile below */
+TilePos RedstoneCircuit::_torchAttachment(const TilePos& pos, int data)
+{
+	switch(data & 7)
+	{
+	case 1:
+		return TilePos(pos.x - 1, pos.y, pos.z);
+	case 2:
+		return TilePos(pos.x + 1, pos.y, pos.z);
+	case 3:
+		return TilePos(pos.x, pos.y, pos.z - 1);
+	case 4:
+		return TilePos(pos.x, pos.y, pos.z + 1);
+	default:
+		return TilePos(pos.x, pos.y - 1, pos.z);
+	}
+}
+
+/* Buttons and levers hang like torches, levers 0 and 7 hang from the ceiling, plates lie on the tile below */
+TilePos RedstoneCircuit::_sourceAttachment(Tile* tile, const TilePos& pos, int data)
+{
+	if(tile == Tile::pressurePlate_stone || tile == Tile::pressurePlate_wood)
+	{
+		return TilePos(pos.x, pos.y - 1, pos.z);
+	}
+	if(tile == Tile::lever && ((data & 7) == 0 || (data & 7) == 7))
+	{
+		return TilePos(pos.x, pos.y + 1, pos.z);
+	}
+
+	return _torchAttachment(pos, data);
+}
+
+/* Repeaters read from the side given by data & 3 and output on the opposite one */
+TilePos RedstoneCircuit::_diodeInput(const TilePos& pos, int data)
+{
+	static const int OFFSET_X[4] = {0, -1, 0, 1};
+	static const int OFFSET_Z[4] = {1, 0, -1, 0};
+	return TilePos(pos.x + OFFSET_X[data & 3], pos.y, pos.z + OFFSET_Z[data & 3]);
+}
+
+TilePos RedstoneCircuit::_diodeOutput(const TilePos& pos, int data)
+{
+	TilePos input = _diodeInput(pos, data);
+	return TilePos(2 * pos.x - input.x, pos.y, 2 * pos.z - input.z);
+}
+
+/* data >> 2 is the number of extra delay steps set on the repeater */
+int RedstoneCircuit::_diodeDelay(int data)
+{
+	return (((data >> 2) & 3) + 1) * GATE_DELAY;
+}
+
+bool RedstoneCircuit::_readSource(TileSource& region, Tile* tile, const TilePos& pos)
+{
+	if(!tile)
+	{
+		return false;
+	}
+	for(int dir = 0; dir < 6; dir++)
+	{
+		TILE_HOOK_SCOPE(tile->blockId, GET_SIGNAL);
+		if(tile->getSignal(&region, pos.x, pos.y, pos.z, dir))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Dust climbing a side needs nothing solid over the lower dust, the same cut the dust tile makes */
+bool RedstoneCircuit::_wireStepOpen(TileSource& region, const TilePos& pos, int step)
+{
+	const int* offset = WIRE_STEP_OFFSET[step];
+	if(offset[1] > 0)
+	{
+		return !Tile::solid[region.getTile(pos.x, pos.y + 1, pos.z).blockId];
+	}
+
+	return !Tile::solid[region.getTile(pos.x + offset[0], pos.y, pos.z + offset[2]).blockId];
+}
+
+int RedstoneCircuit::_find(const TilePos& pos) const
+{
+	auto it = nodeAt.find(_key(pos));
+	return (it != nodeAt.end())? it->second : -1;
+}
+
+bool RedstoneCircuit::contains(const TilePos& pos) const
+{
+	return _find(pos) >= 0;
+}
+
+bool RedstoneCircuit::compile(TileSource& region, const TilePos& seed)
+{
+	nodes.clear();
+	nodeAt.clear();
+	pending.clear();
+	reported.clear();
+	for(int i = 0; i < WHEEL_SIZE; i++)
+	{
+		wheel[i].clear();
+	}
+	tick = 0;
+	dirty = false;
+
+	/* discover every redstone tile reachable through at most one solid tile; a position is
+		queued again when it is reached through fewer solids, so the result doesn't depend
+		on which path got there first
+	*/
+	std::vector<TilePos> found;
+	std::unordered_map<uint64_t, int> bestGap;
+	std::unordered_set<uint64_t> added;
+	std::deque<std::pair<TilePos, int>> frontier;
+	frontier.push_back(std::make_pair(seed, 0));
+	bestGap[_key(seed)] = 0;
+
+	bool hasRedstone = false;
+	while(!frontier.empty() && (int) found.size() < MAX_POSITIONS)
+	{
+		TilePos pos = frontier.front().first;
+		int gap = frontier.front().second;
+		frontier.pop_front();
+
+		uint64_t key = _key(pos);
+		if(gap > bestGap[key] || added.count(key))
+		{
+			continue;
+		}
+
+		TileID blockId = region.getTile(pos.x, pos.y, pos.z).blockId;
+		bool isRedstone = isRedstoneTile(blockId);
+		if(isRedstone)
+		{
+			hasRedstone = true;
+			gap = 0;
+		}
+		else if(gap >= 1 || !Tile::solid[blockId])
+		{
+			continue;
+		}
+		else
+		{
+			gap++;
+		}
+		added.insert(key);
+		found.push_back(pos);
+
+		for(int i = 0; i < 6 + (_classify(blockId) == WIRE? 8 : 0); i++)
+		{
+			if(i >= 6 && !_wireStepOpen(region, pos, i - 6))
+			{
+				continue;
+			}
+
+			TilePos next = (i < 6)? _offset(pos, NEIGHBOUR_OFFSET[i]) : _offset(pos, WIRE_STEP_OFFSET[i - 6]);
+			if(next.y < 0 || next.y >= 128)
+			{
+				continue;
+			}
+
+			auto best = bestGap.find(_key(next));
+			if(best != bestGap.end() && best->second <= gap)
+			{
+				continue;
+			}
+			bestGap[_key(next)] = gap;
+			frontier.push_back(std::make_pair(next, gap));
+		}
+	}
+
+	if(!hasRedstone)
+	{
+		return false;
+	}
+
+	/* one node per tile, levels start out as the world has them */
+	for(const TilePos& pos : found)
+	{
+		FullTile tile = region.getTileAndData(pos);
+		Tile* type = Tile::tiles[tile.blockId];
+
+		Node node;
+		node.type = _classify(tile.blockId);
+		node.level = 0;
+		node.data = tile.data;
+		node.delay = GATE_DELAY;
+		node.wireSteps = 0;
+		node.sourceState = false;
+		node.scheduled = false;
+		node.reported = false;
+		node.pos = pos;
+		node.io = pos;
+		switch(node.type)
+		{
+		case WIRE:
+			node.level = tile.data & MAX_LEVEL;
+			for(int step = 0; step < 8; step++)
+			{
+				if(_wireStepOpen(region, pos, step))
+				{
+					node.wireSteps |= 1 << step;
+				}
+			}
+			break;
+		case NOT_GATE:
+			node.io = _torchAttachment(pos, tile.data);
+			node.level = (type == Tile::notGate_on)? MAX_LEVEL : 0;
+			break;
+		case DIODE:
+			node.io = _diodeInput(pos, tile.data);
+			node.delay = _diodeDelay(tile.data);
+			node.level = (type == Tile::diode_on)? MAX_LEVEL : 0;
+			break;
+		case SOURCE:
+			node.io = _sourceAttachment(type, pos, tile.data);
+			// fall through
+		case POLLED:
+			node.sourceState = _readSource(region, type, pos);
+			node.level = node.sourceState? MAX_LEVEL : 0;
+			break;
+		default:
+			break;
+		}
+
+		nodeAt[_key(pos)] = nodes.size();
+		nodes.push_back(node);
+	}
+
+	_buildEdges();
+
+	/* blocks only hold what their neighbours give them */
+	for(size_t i = 0; i < nodes.size(); i++)
+	{
+		if(nodes[i].type == BLOCK)
+		{
+			nodes[i].level = _evaluate(i);
+		}
+	}
+
+	/* anything the world disagrees with gets settled by the first propagate() */
+	queued.assign(nodes.size(), false);
+	for(size_t i = 0; i < nodes.size(); i++)
+	{
+		if(_evaluate(i) != nodes[i].level)
+		{
+			_queue(i);
+		}
+	}
+
+	return true;
+}
+
+/* Whether a gate or source feeds the tile at target at full strength */
+bool RedstoneCircuit::_drives(int driver, const TilePos& target) const
+{
+	const Node& node = nodes[driver];
+	switch(node.type)
+	{
+	case DIODE:
+		return _samePos(_diodeOutput(node.pos, node.data), target);
+	case NOT_GATE:
+		return !_samePos(node.io, target);
+	case SOURCE:
+	case POLLED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Drivers of each node, in the direction power flows */
+void RedstoneCircuit::_buildEdges()
+{
+	std::vector<std::pair<int, Input>> edges; // (consumer, driver)
+	auto addEdge = [&edges](int consumer, int driver, InputType type)
+	{
+		Input input;
+		input.node = driver;
+		input.type = type;
+		edges.push_back(std::make_pair(consumer, input));
+	};
+
+	for(size_t i = 0; i < nodes.size(); i++)
+	{
+		const Node& node = nodes[i];
+		switch(node.type)
+		{
+		case WIRE:
+			for(int d = 0; d < 14; d++)
+			{
+				if(d >= 6 && !(node.wireSteps & (1 << (d - 6))))
+				{
+					continue;
+				}
+
+				TilePos next = (d < 6)? _offset(node.pos, NEIGHBOUR_OFFSET[d]) : _offset(node.pos, WIRE_STEP_OFFSET[d - 6]);
+				int driver = _find(next);
+				if(driver < 0)
+				{
+					continue;
+				}
+
+				NodeType type = nodes[driver].type;
+				if(type == WIRE && d >= 2)
+				{
+					addEdge(i, driver, DECAY);
+				}
+				else if(d >= 6)
+				{
+					continue; // only dust connects diagonally
+				}
+				else if(type == BLOCK)
+				{
+					addEdge(i, driver, STRONG);
+				}
+				else if(_drives(driver, node.pos))
+				{
+					addEdge(i, driver, DIRECT);
+				}
+			}
+			break;
+		case BLOCK:
+			for(int d = 0; d < 6; d++)
+			{
+				int driver = _find(_offset(node.pos, NEIGHBOUR_OFFSET[d]));
+				if(driver < 0)
+				{
+					continue;
+				}
+
+				/* dust on top or beside, a torch underneath, a facing repeater or an attached switch */
+				const Node& other = nodes[driver];
+				if(other.type == WIRE && d != 0)
+				{
+					addEdge(i, driver, WEAK);
+				}
+				else if((other.type == NOT_GATE && d == 0) ||
+					(other.type == DIODE && _drives(driver, node.pos)) ||
+					(other.type == SOURCE && _samePos(other.io, node.pos)))
+				{
+					addEdge(i, driver, DIRECT);
+				}
+			}
+			break;
+		case NOT_GATE:
+		case DIODE:
+		{
+			/* gates read the one tile behind them, whatever powers it */
+			int driver = _find(node.io);
+			if(driver >= 0)
+			{
+				NodeType type = nodes[driver].type;
+				if(type == WIRE || type == BLOCK || _drives(driver, node.pos))
+				{
+					addEdge(i, driver, DIRECT);
+				}
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	/* compact both directions, begin[n]..begin[n + 1] */
+	int count = nodes.size();
+	inputBegin.assign(count + 1, 0);
+	outputBegin.assign(count + 1, 0);
+	for(const std::pair<int, Input>& edge : edges)
+	{
+		inputBegin[edge.first + 1]++;
+		outputBegin[edge.second.node + 1]++;
+	}
+	for(int i = 0; i < count; i++)
+	{
+		inputBegin[i + 1] += inputBegin[i];
+		outputBegin[i + 1] += outputBegin[i];
+	}
+
+	inputs.resize(edges.size());
+	outputs.assign(edges.size(), 0);
+	std::vector<int> inputFill(inputBegin.begin(), inputBegin.end() - 1);
+	std::vector<int> outputFill(outputBegin.begin(), outputBegin.end() - 1);
+	for(const std::pair<int, Input>& edge : edges)
+	{
+		inputs[inputFill[edge.first]++] = edge.second;
+		outputs[outputFill[edge.second.node]++] = edge.first;
+	}
+}
+
+/* The level the node should have given its drivers' current levels */
+int RedstoneCircuit::_evaluate(int index) const
+{
+	const Node& node = nodes[index];
+	if(node.type == SOURCE || node.type == POLLED)
+	{
+		return node.sourceState? MAX_LEVEL : 0;
+	}
+
+	int best = 0;
+	for(int i = inputBegin[index]; i < inputBegin[index + 1] && best < MAX_LEVEL; i++)
+	{
+		int level = nodes[inputs[i].node].level;
+		switch(inputs[i].type)
+		{
+		case DIRECT:
+			level = level? MAX_LEVEL : 0;
+			break;
+		case DECAY:
+			level = std::max(level - 1, 0);
+			break;
+		case WEAK:
+			level = level? 1 : 0;
+			break;
+		case STRONG:
+			level = (level == MAX_LEVEL)? MAX_LEVEL : 0;
+			break;
+		}
+		best = std::max(best, level);
+	}
+
+	switch(node.type)
+	{
+	case NOT_GATE:
+		return best? 0 : MAX_LEVEL;
+	case DIODE:
+		return best? MAX_LEVEL : 0;
+	default:
+		return best;
+	}
+}
+
+void RedstoneCircuit::_queue(int index)
+{
+	if(!queued[index])
+	{
+		queued[index] = true;
+		pending.push_back(index);
+	}
+}
+
+/* Gates look at their input again once the delay is over, so short pulses are dropped */
+void RedstoneCircuit::_schedule(int index)
+{
+	Node& node = nodes[index];
+	if(!node.scheduled && _evaluate(index) != node.level)
+	{
+		node.scheduled = true;
+		wheel[(tick + node.delay) % WHEEL_SIZE].push_back(index);
+	}
+}
+
+void RedstoneCircuit::_setLevel(int index, int level, std::vector<TileChange>& changes)
+{
+	Node& node = nodes[index];
+	node.level = level;
+	if(node.type == NOT_GATE || node.type == DIODE)
+	{
+		TileChange change;
+		change.pos = node.pos;
+		change.data = node.data;
+		if(node.type == NOT_GATE)
+		{
+			change.tileId = (level? Tile::notGate_on : Tile::notGate_off)->blockId;
+		}
+		else
+		{
+			change.tileId = (level? Tile::diode_on : Tile::diode_off)->blockId;
+		}
+		changes.push_back(change);
+	}
+	else if(node.type == WIRE && !node.reported)
+	{
+		/* dust can change several times while settling, the world only sees the final level */
+		node.reported = true;
+		reported.push_back(index);
+	}
+
+	for(int i = outputBegin[index]; i < outputBegin[index + 1]; i++)
+	{
+		_queue(outputs[i]);
+	}
+}
+
+void RedstoneCircuit::onTileChanged(TileSource& region, const TilePos& pos)
+{
+	FullTile tile = region.getTileAndData(pos);
+	int index = _find(pos);
+	if(index < 0)
+	{
+		/* new redstone, or a new solid tile that could carry power between nodes */
+		bool touches = false;
+		for(int d = 0; d < 6 && !touches; d++)
+		{
+			touches = _find(_offset(pos, NEIGHBOUR_OFFSET[d])) >= 0;
+		}
+		if(isRedstoneTile(tile.blockId) || (touches && Tile::solid[tile.blockId]))
+		{
+			dirty = true;
+		}
+		return;
+	}
+
+	Node& node = nodes[index];
+	if(_classify(tile.blockId) != node.type || (node.type == BLOCK && !Tile::solid[tile.blockId]))
+	{
+		dirty = true;
+		return;
+	}
+
+	switch(node.type)
+	{
+	case SOURCE:
+	case POLLED:
+		node.sourceState = _readSource(region, Tile::tiles[tile.blockId], pos);
+		_queue(index);
+		break;
+	case NOT_GATE:
+		if(tile.data != node.data)
+		{
+			dirty = true; // moved to another attachment
+		}
+		break;
+	case DIODE:
+		if((tile.data & 3) != (node.data & 3))
+		{
+			dirty = true; // turned around
+		}
+		node.data = tile.data;
+		node.delay = _diodeDelay(tile.data);
+		break;
+	case WIRE:
+		node.data = tile.data;
+		break;
+	default:
+		break;
+	}
+}
+
+int RedstoneCircuit::propagate(TileSource& region, std::vector<TileChange>& changes)
+{
+	tick++;
+
+	/* gates whose delay ran out */
+	std::vector<int> due;
+	due.swap(wheel[tick % WHEEL_SIZE]);
+	for(int index : due)
+	{
+		nodes[index].scheduled = false;
+		int level = _evaluate(index);
+		if(level != nodes[index].level)
+		{
+			_setLevel(index, level, changes);
+		}
+	}
+
+	/* wires and blocks settle within the tick, dust levels only ever drop to the next lower fixpoint so this ends */
+	int evaluated = due.size();
+	while(!pending.empty())
+	{
+		int index = pending.front();
+		pending.pop_front();
+		queued[index] = false;
+		evaluated++;
+
+		Node& node = nodes[index];
+		if(node.type == NOT_GATE || node.type == DIODE)
+		{
+			_schedule(index);
+			continue;
+		}
+
+		int level = _evaluate(index);
+		if(level != node.level)
+		{
+			_setLevel(index, level, changes);
+		}
+	}
+
+	for(int index : reported)
+	{
+		Node& node = nodes[index];
+		node.reported = false;
+		if(node.level != node.data)
+		{
+			node.data = node.level;
+
+			TileChange change;
+			change.pos = node.pos;
+			change.tileId = Tile::redStoneDust->blockId;
+			change.data = node.data;
+			changes.push_back(change);
+		}
+	}
+	reported.clear();
+
+	return evaluated;
+}
+
+bool RedstoneCircuit::isPowered(const TilePos& pos) const
+{
+	return getLevel(pos) > 0;
+}
+
+int RedstoneCircuit::getLevel(const TilePos& pos) const
+{
+	int index = _find(pos);
+	return (index >= 0)? nodes[index].level : 0;
+}
+
+int RedstoneCircuit::verify(TileSource& region) const
+{
+	int mismatches = 0;
+	for(const Node& node : nodes)
+	{
+		FullTile tile = region.getTileAndData(node.pos);
+		if(node.type != BLOCK)
+		{
+			/* dust keeps its level in data, everything else only says whether it is on */
+			bool on = _readSource(region, Tile::tiles[tile.blockId], node.pos);
+			if(on != (node.level > 0) || (node.type == WIRE && (tile.data & MAX_LEVEL) != node.level))
+			{
+				mismatches++;
+			}
+			continue;
+		}
+
+		/* a block is powered by what its neighbours say towards it, strongly if it is a direct signal */
+		bool strong = false, powered = false;
+		for(int d = 0; d < 6; d++)
+		{
+			TilePos next = _offset(node.pos, NEIGHBOUR_OFFSET[d]);
+			Tile* neighbour = Tile::tiles[region.getTile(next.x, next.y, next.z).blockId];
+			if(!neighbour)
+			{
+				continue;
+			}
+
+			TILE_HOOK_SCOPE(neighbour->blockId, GET_SIGNAL);
+			strong = strong || neighbour->getDirectSignal(&region, next.x, next.y, next.z, d);
+			powered = powered || neighbour->getSignal(&region, next.x, next.y, next.z, d);
+		}
+		if(strong != (node.level == MAX_LEVEL) || (strong || powered) != (node.level > 0))
+		{
+			mismatches++;
+		}
+	}
+
+	return mismatches;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* A connected redstone contraption compiled into a netlist
+	Every dust tile is a wire node carrying a 0-15 level that drops by one per tile.
+	Solid tiles touching the contraption are block nodes, strongly powered by an
+	attached lever or button, a torch below them or a repeater facing them, and weakly
+	powered by dust; gates read both, dust only passes strong power on. Torches
+	(notGate_on / notGate_off) and repeaters (diode_on / diode_off) are gates that
+	switch after their delay, levers, buttons and pressure plates are sources, and any
+	other isSignalSource() tile is a polled node that still asks Tile::getSignal.
+
+	propagate() advances one game tick: due gates switch, then wires and blocks are
+	re-evaluated from a worklist until nothing changes. Only nodes downstream of a
+	change are visited, and the tiles whose id or dust level must change in the world
+	are reported back to the caller.
+
+	Callers keep the per-tile getSignal path unless setEnabled(true) was called, and
+	it stays off until verify() reports no mismatches against that path.
+*/
+class RedstoneCircuit
+{
+public:
+	enum NodeType : uint8_t
+	{
+		SOURCE,
+		WIRE,
+		BLOCK,
+		NOT_GATE,
+		DIODE,
+		POLLED
+	};
+
+	struct TileChange
+	{
+		TilePos pos;
+		TileID tileId;
+		DataID data;
+	};
+
+	static const int MAX_POSITIONS = 65536;
+	static const int MAX_LEVEL = 15;
+	/* game ticks, repeaters wait one to four times this */
+	static const int GATE_DELAY = 2;
+
+	RedstoneCircuit();
+
+	static void setEnabled(bool);
+	static bool isEnabled();
+
+	/* Flood fills the component around seed, returns false if there is none */
+	bool compile(TileSource&, const TilePos&);
+	bool isCompiled() const { return !nodes.empty(); }
+	bool needsRecompile() const { return dirty; }
+	bool contains(const TilePos&) const;
+
+	/* A source toggled or a tile of the circuit changed; structural changes mark it dirty */
+	void onTileChanged(TileSource&, const TilePos&);
+	/* Advances one game tick, changes receives the tiles to set in the world */
+	int propagate(TileSource&, std::vector<TileChange>& changes);
+
+	bool isPowered(const TilePos&) const;
+	int getLevel(const TilePos&) const;
+	int getNodeCount() const { return nodes.size(); }
+	/* Compares every node with the per-tile getSignal path, returns the mismatches */
+	int verify(TileSource&) const;
+
+	static bool isRedstoneTile(TileID);
+
+private:
+	/* how a driver's level reaches the node it feeds */
+	enum InputType : uint8_t
+	{
+		DIRECT, // any power is full power
+		DECAY, // dust to dust, one level lost
+		WEAK, // dust into a block, only gates see it
+		STRONG // block into dust, only strong power passes
+	};
+
+	struct Input
+	{
+		int node;
+		InputType type;
+	};
+
+	struct Node
+	{
+		NodeType type;
+		uint8_t level;
+		uint8_t data;
+		uint8_t delay;
+		uint8_t wireSteps; // dust, bit i set when the i-th up or down step isn't cut by a solid tile
+		bool sourceState;
+		bool scheduled;
+		bool reported;
+		TilePos pos;
+		TilePos io; // attached block for torches and sources, input tile for repeaters
+	};
+
+	/* longer than the slowest repeater */
+	static const int WHEEL_SIZE = 16;
+
+	static bool enabled;
+
+	std::vector<Node> nodes;
+	std::vector<int> inputBegin, outputBegin; // compact adjacency, begin has one extra entry
+	std::vector<Input> inputs;
+	std::vector<int> outputs;
+	std::unordered_map<uint64_t, int> nodeAt;
+	std::deque<int> pending;
+	std::vector<bool> queued;
+	std::vector<int> wheel[WHEEL_SIZE];
+	std::vector<int> reported;
+	int tick;
+	bool dirty;
+
+	static uint64_t _key(int x, int y, int z)
+	{
+		return ((uint64_t) (x & 0x3FFFFFF) << 38) | ((uint64_t) (z & 0x3FFFFFF) << 12) | (uint64_t) (y & 0xFFF);
+	}
+
+	static uint64_t _key(const TilePos& pos)
+	{
+		return _key(pos.x, pos.y, pos.z);
+	}
+
+	int _find(const TilePos&) const;
+	static NodeType _classify(TileID);
+	static bool _readSource(TileSource&, Tile*, const TilePos&);
+	static bool _wireStepOpen(TileSource&, const TilePos&, int);
+	static TilePos _torchAttachment(const TilePos&, int);
+	static TilePos _sourceAttachment(Tile*, const TilePos&, int);
+	static TilePos _diodeInput(const TilePos&, int);
+	static TilePos _diodeOutput(const TilePos&, int);
+	static int _diodeDelay(int);
+	bool _drives(int, const TilePos&) const;
+	int _evaluate(int) const;
+	void _queue(int);
+	void _schedule(int);
+	void _setLevel(int, int, std::vector<TileChange>&);
+	void _buildEdges();
+};
@@ -0,0 +1,41 @@
+#include "FaceCullingTable.h"
+#include "Tile.h"
+
+uint8_t FaceCullingTable::policies[256][6];
+
+/* Mirrors the pointer comparisons Tile::shouldRenderFace used to do per call
+	Invisible bedrock and the top of snow layers and carpets cull like any other
+	registered tile, only empty slots and leaves need their own policy
+*/
+void FaceCullingTable::build()
+{
+	for(int id = 0; id < 256; id++)
+	{
+		Tile* tile = Tile::tiles[id];
+		for(int face = 0; face < 6; face++)
+		{
+			Policy policy = CULL;
+			if(!tile)
+			{
+				policy = RENDER;
+			}
+			else if(tile == Tile::leaves || tile == Tile::leaves2)
+			{
+				policy = LEAF_DEPTH;
+			}
+
+			policies[id][face] = policy;
+		}
+	}
+}
+
+void FaceCullingTable::clear()
+{
+	for(int id = 0; id < 256; id++)
+	{
+		for(int face = 0; face < 6; face++)
+		{
+			policies[id][face] = RENDER;
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+/* Per-ID, per-face outcome of the neighbour special cases in Tile::shouldRenderFace
+	Built from Tile::initTiles() once the static tile pointers are set,
+	so culling against invisible bedrock, snow layers, carpets and leaves is one byte read.
+*/
+class FaceCullingTable
+{
+public:
+	enum Policy : uint8_t
+	{
+		RENDER, // neighbour never hides the face
+		CULL, // neighbour always hides the face
+		LEAF_DEPTH // hidden unless the neighbour is a leaf on the edge of its canopy
+	};
+
+	static void build();
+	static void clear();
+
+	static Policy get(TileID neighbourId, FacingID face)
+	{
+		return (Policy) policies[neighbourId][face];
+	}
+
+private:
+	static uint8_t policies[256][6];
+};
@@ -1,6 +1,21 @@
 
 
 #include "Tile.h"
+#include "TileProperties.h"
+#include "TileNameIndex.h"
+#include "TileNameTable.h"
+#include "FaceCullingTable.h"
+#include "TileTextureTable.h"
+#include "TileCapabilities.h"
+#include "TileStateTable.h"
+#include "client/renderer/chunk/FaceVisibilityMask.h"
+#include "client/renderer/chunk/DeepLeafMask.h"
+#include "client/renderer/chunk/TessellationTemplateCache.h"
+#include "world/phys/TileShapeCache.h"
+#include "world/phys/TileRaycaster.h"
+#include "world/entity/item/ItemDropBatch.h"
+#include "world/level/biome/BiomeTintCache.h"
+#include "world/entity/ai/pathfinder/NavGrid.h"
 
 Tile::Tile(int blockId, const Material* material)
 {
@@ -29,13 +44,75 @@ Tile::Tile(int blockId, const Material* material)
 	translucency[blockId] = -1.0F;
 	solid[blockId] = true;
 	lightBlock[blockId] = 0xFF;
+	TileCapabilities::reset(blockId);
 }
 Tile::Tile(int blockId, TextureUVCoordinateSet texture, const Material* material) : Tile(blockId, material), texture(texture){}
-Tile::Tile(int blockId, std::string texture, const Material* material) : Tile(blockId, getTextureUVCoordinateSet(texture, 0), material){}
+Tile::Tile(int blockId, std::string texture, const Material* material) : Tile(blockId, getTextureUVCoordinateSet(texture, 0), material)
+{
+	TileTextureTable::bind(blockId, TileTextureTable::resolve(texture));
+}
+
+static bool _sameUV(const TextureUVCoordinateSet& a, const TextureUVCoordinateSet& b)
+{
+	return a._u0 == b._u0 && a._v0 == b._v0 && a._u1 == b._u1 && a._v1 == b._v1;
+}
 
+/* Installing a new atlas swaps the UV table, tiles don't need to be rebuilt
+	A tile still showing the texture it was bound to moves to the new atlas; one whose
+	texture was reassigned since keeps it and loses the binding.
+	The texture fields are plain members that getTexture() and every subclass read
+	without synchronisation, so they are rewritten in place: call this only while no
+	mesher or other thread can be reading tiles, on the render thread before section
+	rebuilds are scheduled again. Only TileTextureTable lookups are safe across it.
+*/
 void Tile::setTextureAtlas(std::shared_ptr<TextureAtlas> _atlas)
 {
+	TileTextureTable::Ref previous = TileTextureTable::acquire();
 	_terrainTextureAtlas = _atlas;
+	if(_atlas)
+	{
+		TileTextureTable::rebuild(*_atlas);
+
+		TileTextureTable::Ref table = TileTextureTable::acquire();
+		for(int i = 0; i < 256; i++)
+		{
+			TileTextureTable::Handle handle = TileTextureTable::getBinding(i);
+			if(!tiles[i] || handle == TileTextureTable::NONE || handle >= previous->first.size())
+			{
+				continue;
+			}
+
+			if(_sameUV(tiles[i]->texture, previous->getUV(handle)))
+			{
+				tiles[i]->texture = table->getUV(handle);
+			}
+			else
+			{
+				TileTextureTable::unbind(i);
+			}
+		}
+
+		TileStateTable::build();
+		TessellationTemplateCache::build();
+	}
+}
+
+void Tile::setBiomeTintCache(BiomeTintCache* tints)
+{
+	_biomeTints = tints;
+}
+
+/* Blended grass, foliage or water colour for getColor(TileSource*, ...) overrides,
+	tintClass is a BiomeTintCache::TintClass
+*/
+int Tile::getBiomeTint(TileSource* region, int x, int z, int tintClass)
+{
+	if(!_biomeTints)
+	{
+		return 0xFFFFFFFF;
+	}
+
+	return _biomeTints->getColor(*region, x, z, (BiomeTintCache::TintClass) tintClass);
 }
 
 TileID Tile::transformToValidBlockId(TileID oldID)
@@ -58,20 +135,23 @@ TileID Tile::transformToValidBlockId(TileID oldID, int x, int y, int z)
 	}
 }
 
+/* Case-insensitive lookup through TileNameIndex, no allocation per call */
 int Tile::getIDByName(const std::string& name, bool par1bool)
 {
-	/* TODO */
-	for(Tile* tile : tiles)
+	int blockId = TileNameIndex::find(name);
+	if(blockId != TileNameIndex::NOT_FOUND)
 	{
-		if(Util::toLower(tile->getDescriptionId()) == Util::toLower(name))
-		{
-			return tile->blockId;
-		}
+		return blockId;
 	}
 
 	return 0xFFFFFFFF; // I don't know why it returns this
 }
 
+void Tile::getIDsByName(const std::vector<std::string>& names, std::vector<int>& ids)
+{
+	TileNameIndex::findAll(names, ids);
+}
+
 bool Tile::isTileType(const FullTile& tile, TileType checkType)
 {
 	return tiles[tile.blockId] && tiles[tile.blockId]->tileType == checkType;
@@ -99,6 +179,14 @@ bool Tile::isFaceVisible(TileSource* region, int x, int y, int z, FacingID face)
 	}
 }
 
+/* Same test answered from the mask of the section containing the tile
+	The mesher builds one mask per section, face must be 0-5
+*/
+bool Tile::isFaceVisible(const FaceVisibilityMask& mask, int x, int y, int z, FacingID face)
+{
+	return mask.isVisible(x & 15, y & 15, z & 15, face);
+}
+
 Tile* Tile::getTile(int blockId)
 {
 	return tiles[blockId];
@@ -112,7 +200,7 @@ const Material* Tile::getTileMaterial(int blockId)
 
 int Tile::getLightEmission(const TileID blockId)
 {
-	return lightEmission[blockId];
+	return TileProperties::getLightEmission(blockId);
 }
 
 TileType Tile::getTileType() const
@@ -122,12 +210,12 @@ TileType Tile::getTileType() const
 
 TextureUVCoordinateSet Tile::getTextureUVCoordinateSet(const std::string& textureName, int textureIndex)
 {
-	return _terrainTextureAtlas->getTextureItem(textureName)[textureIndex];
+	return TileTextureTable::getUV(TileTextureTable::resolve(textureName), textureIndex);
 }
 
 const TextureAtlasTextureItem& Tile::getTextureItem(const std::string& textureName)
 {
-	return _terrainTextureAtlas->getTextureItem(textureName);
+	return TileTextureTable::getItem(TileTextureTable::resolve(textureName));
 }
 
 int Tile::getRenderShape() const
@@ -137,7 +225,7 @@ int Tile::getRenderShape() const
 
 float Tile::getShadeBrightness() const
 {
-	if(solid[blockId] || tileType == TileType::LeafTile)
+	if(TileProperties::isSolid(blockId) || tileType == TileType::LeafTile)
 	{
 		return 0.2F;
 	}
@@ -184,6 +272,7 @@ bool Tile::isSolidRender() const
 void Tile::setSolid(bool solid)
 {
 	Tile::solid[blockId] = solid;
+	TileProperties::update(*this);
 }
 
 bool Tile::isUnbreakable() const
@@ -233,9 +322,11 @@ void Tile::popResource(TileSource* region, int x, int y, int z, const ItemInstan
 		return;
 	}
 	/* TODO: random number magic */
-	ItemEntity* droppedItem = new ItemEntity(*region, (float) x, (float) y, (float) z, itemStack);
-	droppedItem->throwTime = 10;
-	level->addEntity(droppedItem);
+	if(ItemDropBatch::add(*region, TilePos(x, y, z), itemStack))
+	{
+		return;
+	}
+	ItemDropBatch::spawn(*region, TilePos(x, y, z), itemStack);
 }
 
 bool Tile::canBeBuiltOver() const
@@ -299,13 +390,33 @@ const AABB& Tile::getShape(DataID, AABB&, bool)
 
 bool Tile::isObstructingChests(TileSource* region, int x, int y, int z)
 {
-	return solid[blockId];
+	return TileProperties::isSolid(blockId);
 }
 
 /* Checks if the given face should be rendered
 	Always returns false with invisible bedrock
 */
 bool Tile::shouldRenderFace(TileSource* region, int x, int y, int z, FacingID face, const AABB& aabb) const
+{
+	return _shouldRenderFace(region, x, y, z, face, aabb, NULL);
+}
+
+/* For the mesher, leaf depth comes from its DeepLeafMask instead of the region;
+	x, y, z is the neighbour, so the mask must be the one of the neighbour's section.
+	Tiles overriding shouldRenderFace still get their own version
+*/
+bool Tile::shouldRenderFaceWithMask(TileSource* region, int x, int y, int z, FacingID face, const AABB& aabb, const DeepLeafMask* deepLeaves) const
+{
+	if(TileCapabilities::has(blockId, TileCapabilities::SHOULD_RENDER_FACE))
+	{
+		return shouldRenderFace(region, x, y, z, face, aabb);
+	}
+
+	return _shouldRenderFace(region, x, y, z, face, aabb, deepLeaves);
+}
+
+/* The neighbour special cases come from FaceCullingTable */
+bool Tile::_shouldRenderFace(TileSource* region, int x, int y, int z, FacingID face, const AABB& aabb, const DeepLeafMask* deepLeaves) const
 {
 	if(face == 0 && aabb.min.y > 0.0F ||
 		face == 1 && aabb.max.y < 1.0F ||
@@ -317,23 +428,19 @@ bool Tile::shouldRenderFace(TileSource* region, int x, int y, int z, FacingID fa
 		return true;
 	}
 
-	Tile* tile = tiles[region->getTileAndData({x, y, z}).blockId];
-	if(!tile)
+	switch(FaceCullingTable::get(region->getTileAndData({x, y, z}).blockId, face))
 	{
+	case FaceCullingTable::RENDER:
 		return true;
-	}
-
-	if((tile == invisible_bedrock) || ((tile == topSnow || tile == woolCarpet) && face == 1))
-	{
-		return false;
-	}
-
-	if(tile == leaves || tile == leaves2)
-	{
+	case FaceCullingTable::LEAF_DEPTH:
+		if(deepLeaves && deepLeaves->isValid())
+		{
+			return !deepLeaves->isDeep(x, y, z);
+		}
 		return !LeafTile::isDeepLeafTile(*region, {x, y, z});
+	default:
+		return false;
 	}
-
-	return false;
 }
 
 const TextureUVCoordinateSet& Tile::getTexture(FacingID side)
@@ -407,7 +514,7 @@ bool Tile::mayPlace(TileSource* region, int x, int y, int z, FacingID face)
 bool Tile::mayPlace(TileSource* region, int x, int y, int z)
 {
 	int blockId = region->getTile(x, y, z).blockId;
-	return blockId == 0 || tiles[blockId]->material->replaceable;
+	return blockId == 0 || TileProperties::isReplaceable(blockId);
 }
 
 int Tile::getTickDelay()
@@ -460,9 +567,21 @@ float Tile::getDestroyProgress(Player* player)
 		return 0.0F;
 	}
 
-	if(player->canDestroy(this))
+	bool canDestroy = player->canDestroy(this);
+	return getDestroyProgressFor(canDestroy, canDestroy? player->getDestroySpeed(this) : 0.0F);
+}
+
+/* The math of getDestroyProgress for a given tool: whether it can harvest the tile and its speed */
+float Tile::getDestroyProgressFor(bool canDestroy, float destroySpeed) const
+{
+	if(destroyTime < 0.0F)
+	{
+		return 0.0F;
+	}
+
+	if(canDestroy)
 	{
-		return (player->getDestroySpeed(this) / destroyTime) * 0.033333;
+		return (destroySpeed / destroyTime) * 0.033333;
 	}
 
 	return 0.01F / destroyTime;
@@ -483,10 +602,24 @@ float Tile::getExplosionResistance(Entity*)
 	return explosionResistance * 0.2F;
 }
 
+/* Intersects the segment par4Vec3 -> par5Vec3 with this tile's shape at x, y, z
+	Used by TileRaycaster for every cell that isn't a plain full cube
+*/
 HitResult Tile::clip(TileSource* region, int x, int y, int z, const Vec3& par4Vec3, const Vec3& par5Vec3, bool par6bool, int par7int)
 {
-	/* TODO: this is not the code you are looking for */
-	return HitResult(x, y, z, 0, par4Vec3);
+	AABB shape;
+	shape.set(getShape(region, x, y, z, shape, false));
+	shape.set(shape.min.x + x, shape.min.y + y, shape.min.z + z, shape.max.x + x, shape.max.y + y, shape.max.z + z);
+
+	float t;
+	FacingID face;
+	if(!TileRaycaster::clipBox(shape, par4Vec3, par5Vec3, t, face))
+	{
+		return HitResult();
+	}
+
+	Vec3 hit(par4Vec3.x + (par5Vec3.x - par4Vec3.x) * t, par4Vec3.y + (par5Vec3.y - par4Vec3.y) * t, par4Vec3.z + (par5Vec3.z - par4Vec3.z) * t);
+	return HitResult(x, y, z, face, hit);
 }
 
 /* Called when this block is blown up by TNT or a Creeper */
@@ -561,8 +694,30 @@ bool Tile::canSurvive(TileSource*, int, int, int)
 
 std::string Tile::getName() const
 {
-	/* TODO: Only certain C++ STLs have std::string::operator+(const std::string&) AFAIK */
-	return I18n::get(getDescriptionId() + ".name");
+	/* subclasses that pick their own description ID aren't in the table */
+	if(TileCapabilities::has(blockId, TileCapabilities::DESCRIPTION_ID))
+	{
+		/* TODO: Only certain C++ STLs have std::string::operator+(const std::string&) AFAIK */
+		return I18n::get(getDescriptionId() + ".name");
+	}
+
+	return TileNameTable::getLocalizedName(blockId);
+}
+
+/* Translated once per locale by TileNameTable, for callers that only read the name
+	Tiles overriding getDescriptionId are translated on every call into a per-thread
+	buffer, the reference stays valid until the next call on the same thread.
+*/
+const std::string& Tile::getLocalizedName() const
+{
+	if(TileCapabilities::has(blockId, TileCapabilities::DESCRIPTION_ID))
+	{
+		static thread_local std::string translated;
+		translated = I18n::get(getDescriptionId() + ".name");
+		return translated;
+	}
+
+	return TileNameTable::getLocalizedName(blockId);
 }
 
 std::string Tile::getDescriptionId() const
@@ -575,6 +730,19 @@ std::string Tile::getDescriptionId(const ItemInstance*) const
 	return getDescriptionId();
 }
 
+/* getDescriptionId without the copy, same per-thread buffer as getLocalizedName for overrides */
+const std::string& Tile::getInternedDescriptionId() const
+{
+	if(TileCapabilities::has(blockId, TileCapabilities::DESCRIPTION_ID))
+	{
+		static thread_local std::string descriptionId;
+		descriptionId = getDescriptionId();
+		return descriptionId;
+	}
+
+	return TileNameTable::getDescriptionId(blockId);
+}
+
 std::string Tile::getTypeDescriptionId(int)
 {
 	return "";
@@ -583,6 +751,8 @@ std::string Tile::getTypeDescriptionId(int)
 Tile* Tile::setDescriptionId(const std::string& descriptionId)
 {
 	name = "tile." + descriptionId;
+	TileNameTable::setDescriptionId(blockId, name);
+	TileNameIndex::add(*this);
 	return this;
 }
 
@@ -625,18 +795,21 @@ Tile* Tile::setSoundType(const Tile::SoundType& soundType)
 Tile* Tile::setLightBlock(int _lightBlock)
 {
 	lightBlock[blockId] = _lightBlock;
+	TileProperties::update(*this);
 	return this;
 }
 
 Tile* Tile::setLightEmission(float _emission)
 {
 	lightEmission[blockId] = _emission * 15.0F;
+	TileProperties::update(*this);
 	return this;
 }
 
 Tile* Tile::setExplodeable(float _explodeable)
 {
 	explosionResistance = _explodeable * 3.0F;
+	TileProperties::update(*this);
 	return this;
 }
 
@@ -648,12 +821,14 @@ Tile* Tile::setDestroyTime(float _time)
 		explosionResistance = _time * 5.0F;
 	}
 
+	TileProperties::update(*this);
 	return this;
 }
 
 void Tile::setTicking(bool _ticking)
 {
 	shouldTick[blockId] = _ticking;
+	TileProperties::update(*this);
 }
 
 int Tile::getSpawnResourcesAuxValue(int)
@@ -674,6 +849,9 @@ Tile* Tile::init()
 		translucency[blockId] = material->translucency;
 	}
 
+	TileProperties::update(*this);
+	TileNameIndex::add(*this);
+	TileCapabilities::update(*this);
 	return this;
 }
 
@@ -697,6 +875,7 @@ float Tile::translucency[256];
 int Tile::lightEmission[256];
 
 std::shared_ptr<TextureAtlas> Tile::_terrainTextureAtlas;
+BiomeTintCache* Tile::_biomeTints = NULL;
 
 Tile* Tile::rock;
 Tile* Tile::grass;
@@ -862,6 +1041,23 @@ Tile* Tile::info_reserved6;
 void Tile::initTiles()
 {
 	/* TODO: Do ALL this */
+
+	/* every constructor has declared its hooks by now, whatever order init() ran in */
+	for(int i = 0; i < 256; i++)
+	{
+		if(tiles[i])
+		{
+			TileCapabilities::update(*tiles[i]);
+		}
+	}
+
+	/* getDescriptionId overrides only answer now */
+	TileNameIndex::rebuild();
+	TileStateTable::build();
+	NavGrid::buildClasses();
+	FaceCullingTable::build();
+	TileShapeCache::build();
+	TessellationTemplateCache::build();
 }
 
 void Tile::teardownTiles()
@@ -876,4 +1072,14 @@ void Tile::teardownTiles()
 		delete tiles[i];
 		tiles[i] = NULL;
 	}
+
+	TileProperties::clearAll();
+	TileNameIndex::clear();
+	FaceCullingTable::clear();
+	TileShapeCache::clear();
+	TileTextureTable::clear();
+	TileNameTable::clear();
+	TessellationTemplateCache::clear();
+	TileCapabilities::clearAll();
+	TileStateTable::clear();
 }
@@ -49,13 +49,17 @@ public:
 
 	/* static functions */
 	static void setTextureAtlas(std::shared_ptr<TextureAtlas>);
+	static void setBiomeTintCache(BiomeTintCache*);
+	static int getBiomeTint(TileSource*, int, int, int);
 	static void initTiles();
 	static void teardownTiles();
 	static TileID transformToValidBlockId(TileID);
 	static TileID transformToValidBlockId(TileID, int, int, int);
 	static int getIDByName(const std::string&, bool);
+	static void getIDsByName(const std::vector<std::string>&, std::vector<int>&);
 	static bool isTileType(const FullTile&, TileType);
 	static bool isFaceVisible(TileSource*, int, int, int, FacingID);
+	static bool isFaceVisible(const FaceVisibilityMask&, int, int, int, FacingID);
 	static Tile* getTile(int);
 	static const Material* getTileMaterial(int);
 	static int getLightEmission(const TileID);
@@ -84,6 +88,11 @@ public:
 	void destroyEffect(TileSource&, const TilePos&, const Vec3&);
 	Tile* setCategory(int);
 	MobSpawnerData* _getTypeToSpawn(TileSource&, int, const TilePos&) const;
+	const std::string& getLocalizedName() const;
+	const std::string& getInternedDescriptionId() const;
+	float getDestroyProgressFor(bool, float) const;
+	bool shouldRenderFaceWithMask(TileSource*, int, int, int, FacingID, const AABB&, const DeepLeafMask*) const;
+	bool _shouldRenderFace(TileSource*, int, int, int, FacingID, const AABB&, const DeepLeafMask*) const;
 
 	Tile(int, const Material*);
 	Tile(int, TextureUVCoordinateSet, const Material*);	Tile(int, TextureUVCoordinateSet, const Material*);
@@ -181,6 +190,7 @@ public:
 	static int lightEmission[];
 
 	static std::shared_ptr<TextureAtlas> _terrainTextureAtlas;
+	static BiomeTintCache* _biomeTints;
 
 	static Tile* rock;
 	static Tile* grass;
@@ -0,0 +1,604 @@
+#include "TileBenchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <unordered_map>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "Tile.h"
+#include "TileCapabilities.h"
+#include "TileNameTable.h"
+
+static std::atomic<uint64_t> allocationCount(0);
+
+#ifdef TILE_BENCHMARK_COUNT_ALLOCATIONS
+/* Counts every heap allocation of the process, only meant for benchmark builds */
+void* operator new(size_t size)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	void* pointer = malloc(size? size : 1);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+	free(pointer);
+}
+#endif
+
+/* Hardware cache misses of this thread, user space only; reads -1 when perf events are
+	missing or not permitted (containers, perf_event_paranoid)
+*/
+class PerfCounter
+{
+public:
+	PerfCounter()
+	{
+		fd = -1;
+#ifdef __linux__
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+
+	~PerfCounter()
+	{
+#ifdef __linux__
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+#endif
+	}
+
+	void start()
+	{
+#ifdef __linux__
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	int64_t stop()
+	{
+#ifdef __linux__
+		uint64_t count = 0;
+		if(fd >= 0)
+		{
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if(read(fd, &count, sizeof(count)) == sizeof(count))
+			{
+				return (int64_t) count;
+			}
+		}
+#endif
+		return -1;
+	}
+
+private:
+	int fd;
+};
+
+/* Blank chunks made on request and kept in memory, nothing is generated, lit or saved;
+	the benchmark writes its terrain into them through TileSource::setTileNoUpdate
+*/
+class BenchmarkChunkSource : public ChunkSource
+{
+public:
+	BenchmarkChunkSource()
+		: ChunkSource(NULL, 16)
+	{
+	}
+
+	virtual LevelChunk* getExistingChunk(const ChunkPos& pos)
+	{
+		auto it = chunks.find(_key(pos));
+		return it != chunks.end()? it->second.get() : NULL;
+	}
+
+	virtual LevelChunk* requestChunk(const ChunkPos& pos, LoadMode)
+	{
+		std::unique_ptr<LevelChunk>& chunk = chunks[_key(pos)];
+		if(!chunk)
+		{
+			chunk.reset(new LevelChunk(NULL, pos, false));
+		}
+		return chunk.get();
+	}
+
+private:
+	std::unordered_map<int64_t, std::unique_ptr<LevelChunk>> chunks;
+
+	static int64_t _key(const ChunkPos& pos)
+	{
+		return ((int64_t) pos.x << 32) | (uint32_t) pos.z;
+	}
+};
+
+static uint32_t _hash(uint32_t seed, int x, int y, int z)
+{
+	uint32_t h = seed ^ (uint32_t) x * 0x27D4EB2Du ^ (uint32_t) y * 0x165667B1u ^ (uint32_t) z * 0x9E3779B1u;
+	h ^= h >> 15;
+	h *= 0x85EBCA77u;
+	h ^= h >> 13;
+	h *= 0xC2B2AE3Du;
+	h ^= h >> 16;
+	return h;
+}
+
+/* Value noise on a 4-tile lattice, 0..1 */
+static float _noise(uint32_t seed, int x, int y, int z)
+{
+	int cx = x >> 2, cy = y >> 2, cz = z >> 2;
+	float fx = (x & 3) / 4.0F, fy = (y & 3) / 4.0F, fz = (z & 3) / 4.0F;
+	float value = 0.0F;
+	for(int i = 0; i < 8; i++)
+	{
+		int ox = i & 1, oy = (i >> 1) & 1, oz = (i >> 2) & 1;
+		float weight = (ox? fx : 1.0F - fx) * (oy? fy : 1.0F - fy) * (oz? fz : 1.0F - fz);
+		value += weight * (_hash(seed, cx + ox, cy + oy, cz + oz) & 0xFFFF) / 65535.0F;
+	}
+
+	return value;
+}
+
+void TileBenchmark::Terrain::set(int x, int y, int z, Tile* tile)
+{
+	if(x < 0 || y < 0 || z < 0 || x >= width || y >= height || z >= depth)
+	{
+		return;
+	}
+
+	ids[index(x, y, z)] = tile? tile->blockId : 0;
+}
+
+TileBenchmark::TileBenchmark(TileSource& region, const TilePos& origin, Player* player)
+	: region(region), origin(origin)
+{
+	this->player = player;
+	iterations = 20;
+	seed = 0x5EED;
+}
+
+void TileBenchmark::setIterations(int _iterations)
+{
+	iterations = _iterations > 1? _iterations : 1;
+}
+
+const char* TileBenchmark::getPresetName(Preset preset)
+{
+	switch(preset)
+	{
+	case PLAINS:
+		return "plains";
+	case FOREST:
+		return "forest";
+	case CAVE:
+		return "cave";
+	default:
+		return "redstone";
+	}
+}
+
+uint64_t TileBenchmark::getAllocationCount()
+{
+	return allocationCount.load(std::memory_order_relaxed);
+}
+
+void TileBenchmark::generate(Preset preset, uint32_t seed, Terrain& terrain)
+{
+	terrain.width = WIDTH;
+	terrain.height = HEIGHT;
+	terrain.depth = WIDTH;
+	terrain.ids.assign(WIDTH * HEIGHT * WIDTH, 0);
+
+	for(int x = 0; x < WIDTH; x++)
+	{
+		for(int z = 0; z < WIDTH; z++)
+		{
+			terrain.set(x, 0, z, Tile::unbreakable);
+
+			switch(preset)
+			{
+			case PLAINS:
+			case FOREST:
+				for(int y = 1; y < 40; y++)
+				{
+					terrain.set(x, y, z, Tile::rock);
+				}
+				for(int y = 40; y < 43; y++)
+				{
+					terrain.set(x, y, z, Tile::dirt);
+				}
+				terrain.set(x, 43, z, Tile::grass);
+				if(_hash(seed, x, 44, z) % 6 == 0)
+				{
+					terrain.set(x, 44, z, Tile::tallgrass);
+				}
+				else if(_hash(seed, x, 44, z) % 40 == 1)
+				{
+					terrain.set(x, 44, z, Tile::yellowFlower);
+				}
+				break;
+			case CAVE:
+				for(int y = 1; y < 60; y++)
+				{
+					float density = _noise(seed, x, y, z);
+					if(density < 0.38F)
+					{
+						terrain.set(x, y, z, y < 8? Tile::calmLava : NULL);
+					}
+					else if(_hash(seed, x, y, z) % 60 == 0)
+					{
+						terrain.set(x, y, z, Tile::coalOre);
+					}
+					else if(_hash(seed, x, y, z) % 120 == 1)
+					{
+						terrain.set(x, y, z, Tile::ironOre);
+					}
+					else
+					{
+						terrain.set(x, y, z, Tile::rock);
+					}
+				}
+				break;
+			default:
+				for(int y = 1; y < 10; y++)
+				{
+					terrain.set(x, y, z, Tile::rock);
+				}
+				break;
+			}
+		}
+	}
+
+	if(preset == FOREST)
+	{
+		/* a tree roughly every 7 tiles, jittered */
+		for(int gx = 3; gx < WIDTH - 3; gx += 7)
+		{
+			for(int gz = 3; gz < WIDTH - 3; gz += 7)
+			{
+				uint32_t h = _hash(seed, gx, 0, gz);
+				int tx = gx + (int) (h % 3) - 1;
+				int tz = gz + (int) ((h >> 8) % 3) - 1;
+				for(int y = 47; y <= 50; y++)
+				{
+					for(int dx = -2; dx <= 2; dx++)
+					{
+						for(int dz = -2; dz <= 2; dz++)
+						{
+							bool corner = abs(dx) == 2 && abs(dz) == 2;
+							if(!corner || _hash(seed, tx + dx, y, tz + dz) & 1)
+							{
+								terrain.set(tx + dx, y, tz + dz, Tile::leaves);
+							}
+						}
+					}
+				}
+				for(int y = 44; y < 50; y++)
+				{
+					terrain.set(tx, y, tz, Tile::log);
+				}
+			}
+		}
+	}
+	else if(preset == REDSTONE)
+	{
+		/* rows of dust fed by a torch, a repeater every 8 tiles and a lever at the end */
+		for(int z = 2; z < WIDTH - 2; z += 4)
+		{
+			terrain.set(1, 10, z, Tile::notGate_on);
+			for(int x = 2; x < WIDTH - 2; x++)
+			{
+				terrain.set(x, 10, z, (x % 8 == 0)? Tile::diode_off : Tile::redStoneDust);
+			}
+			terrain.set(WIDTH - 2, 10, z, Tile::lever);
+		}
+	}
+}
+
+void TileBenchmark::apply(const Terrain& terrain, TileSource& region, const TilePos& origin)
+{
+	for(int y = 0; y < terrain.height; y++)
+	{
+		for(int z = 0; z < terrain.depth; z++)
+		{
+			for(int x = 0; x < terrain.width; x++)
+			{
+				region.setTileNoUpdate(origin.x + x, origin.y + y, origin.z + z, terrain.getId(x, y, z));
+			}
+		}
+	}
+}
+
+template<typename Body>
+TileBenchmark::Result TileBenchmark::_measure(const char* name, Preset preset, uint64_t opsPerIteration, Body body)
+{
+	/* one untimed pass to fault in the terrain and any lazily built tables */
+	body();
+
+	PerfCounter misses;
+	uint64_t allocationsBefore = getAllocationCount();
+	misses.start();
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < iterations; i++)
+	{
+		body();
+	}
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	int64_t missCount = misses.stop();
+	uint64_t allocations = getAllocationCount() - allocationsBefore;
+
+	Result result;
+	result.name = name;
+	result.preset = preset;
+	result.ops = opsPerIteration * iterations;
+	double ops = result.ops? (double) result.ops : 1.0;
+	result.nsPerOp = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / ops;
+#ifdef TILE_BENCHMARK_COUNT_ALLOCATIONS
+	result.allocationsPerOp = allocations / ops;
+#else
+	(void) allocations;
+	result.allocationsPerOp = -1.0;
+#endif
+	result.cacheMissesPerOp = missCount >= 0? missCount / ops : -1.0;
+	result.skippedPerOp = -1.0;
+	return result;
+}
+
+void TileBenchmark::run(Preset preset, std::vector<Result>& results)
+{
+	Terrain terrain;
+	generate(preset, seed, terrain);
+	apply(terrain, region, origin);
+
+	/* surface is every non-air tile touching air, the faces the mesher actually asks about */
+	std::vector<TilePos> all, surface;
+	for(int y = 1; y < terrain.height - 1; y++)
+	{
+		for(int z = 1; z < terrain.depth - 1; z++)
+		{
+			for(int x = 1; x < terrain.width - 1; x++)
+			{
+				TilePos pos(origin.x + x, origin.y + y, origin.z + z);
+				all.push_back(pos);
+
+				if(!terrain.getId(x, y, z))
+				{
+					continue;
+				}
+				if(!terrain.getId(x - 1, y, z) || !terrain.getId(x + 1, y, z) ||
+					!terrain.getId(x, y - 1, z) || !terrain.getId(x, y + 1, z) ||
+					!terrain.getId(x, y, z - 1) || !terrain.getId(x, y, z + 1))
+				{
+					surface.push_back(pos);
+				}
+			}
+		}
+	}
+
+	volatile int sink = 0;
+
+	results.push_back(_measure("isFaceVisible", preset, surface.size() * 6, [&]()
+	{
+		int visible = 0;
+		for(const TilePos& pos : surface)
+		{
+			for(int face = 0; face < 6; face++)
+			{
+				visible += Tile::isFaceVisible(&region, pos.x, pos.y, pos.z, face);
+			}
+		}
+		sink += visible;
+	}));
+
+	results.push_back(_measure("shouldRenderFace", preset, surface.size() * 6, [&]()
+	{
+		static const int OFFSET[6][3] = {{0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}, {-1, 0, 0}, {1, 0, 0}};
+		int rendered = 0;
+		AABB scratch;
+		for(const TilePos& pos : surface)
+		{
+			Tile* tile = Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId];
+			if(!tile)
+			{
+				continue;
+			}
+			const AABB& shape = tile->getShape(region.getData(pos.x, pos.y, pos.z), scratch, false);
+			for(int face = 0; face < 6; face++)
+			{
+				rendered += tile->shouldRenderFace(&region, pos.x + OFFSET[face][0], pos.y + OFFSET[face][1], pos.z + OFFSET[face][2], face, shape);
+			}
+		}
+		sink += rendered;
+	}));
+
+	results.push_back(_measure("addAABBs", preset, surface.size(), [&]()
+	{
+		std::vector<AABB> pool;
+		int boxes = 0;
+		for(const TilePos& pos : surface)
+		{
+			Tile* tile = Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId];
+			if(!tile)
+			{
+				continue;
+			}
+			AABB area((float) pos.x, (float) pos.y, (float) pos.z, pos.x + 1.0F, pos.y + 1.0F, pos.z + 1.0F);
+			pool.clear();
+			tile->addAABBs(&region, pos.x, pos.y, pos.z, &area, pool);
+			boxes += pool.size();
+		}
+		sink += boxes;
+	}));
+
+	results.push_back(_measure("getAABB", preset, surface.size(), [&]()
+	{
+		AABB scratch;
+		float height = 0.0F;
+		for(const TilePos& pos : surface)
+		{
+			Tile* tile = Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId];
+			if(tile)
+			{
+				height += tile->getAABB(&region, pos.x, pos.y, pos.z, scratch, region.getData(pos.x, pos.y, pos.z), false, 0).max.y;
+			}
+		}
+		sink += (int) height;
+	}));
+
+	/* registered names plus the same number of misses, the lookup has to reject those too */
+	std::vector<std::string> names;
+	for(int i = 0; i < 256; i++)
+	{
+		if(Tile::tiles[i] && !TileNameTable::getDescriptionId(i).empty())
+		{
+			names.push_back(TileNameTable::getDescriptionId(i));
+			names.push_back(TileNameTable::getDescriptionId(i) + "_missing");
+		}
+	}
+
+	results.push_back(_measure("getIDByName", preset, names.size(), [&]()
+	{
+		int found = 0;
+		for(const std::string& name : names)
+		{
+			found += Tile::getIDByName(name, false) != (int) 0xFFFFFFFF;
+		}
+		sink += found;
+	}));
+
+	results.push_back(_measure("transformToValidBlockId", preset, all.size(), [&]()
+	{
+		int total = 0;
+		for(const TilePos& pos : all)
+		{
+			total += Tile::transformToValidBlockId(region.getTile(pos.x, pos.y, pos.z).blockId, pos.x, pos.y, pos.z);
+		}
+		sink += total;
+	}));
+
+	if(player)
+	{
+		results.push_back(_measure("getDestroyProgress", preset, surface.size(), [&]()
+		{
+			float progress = 0.0F;
+			for(const TilePos& pos : surface)
+			{
+				Tile* tile = Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId];
+				if(tile)
+				{
+					progress += tile->getDestroyProgress(player);
+				}
+			}
+			sink += (int) progress;
+		}));
+	}
+	else
+	{
+		results.push_back(_measure("getDestroyProgress (tool inputs)", preset, surface.size(), [&]()
+		{
+			static const bool CAN_DESTROY[3] = {true, false, true};
+			static const float SPEED[3] = {1.0F, 1.0F, 8.0F};
+			float progress = 0.0F;
+			int tool = 0;
+			for(const TilePos& pos : surface)
+			{
+				Tile* tile = Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId];
+				if(tile)
+				{
+					progress += tile->getDestroyProgressFor(CAN_DESTROY[tool], SPEED[tool]);
+				}
+				tool = (tool + 1) % 3;
+			}
+			sink += (int) progress;
+		}));
+	}
+
+	/* the calls TileCapabilities lets the tick loops skip, one neighbour update per tile */
+	int overridden = 0;
+	Result hooks = _measure("neighborChanged filter", preset, all.size(), [&]()
+	{
+		int dispatch = 0;
+		for(const TilePos& pos : all)
+		{
+			TileID blockId = region.getTile(pos.x, pos.y, pos.z).blockId;
+			dispatch += Tile::tiles[blockId] && TileCapabilities::has(blockId, TileCapabilities::NEIGHBOR_CHANGED);
+		}
+		overridden = dispatch;
+	});
+	int present = 0;
+	for(const TilePos& pos : all)
+	{
+		present += Tile::tiles[region.getTile(pos.x, pos.y, pos.z).blockId] != NULL;
+	}
+	hooks.skippedPerOp = present? (double) (present - overridden) / present : 0.0;
+	results.push_back(hooks);
+}
+
+void TileBenchmark::runAll(std::vector<Result>& results)
+{
+	for(int preset = 0; preset < PRESET_COUNT; preset++)
+	{
+		run((Preset) preset, results);
+	}
+}
+
+void TileBenchmark::runHeadless(FILE* out, int iterations)
+{
+	BenchmarkChunkSource source;
+	TileSource region(NULL, &source, false, true);
+
+	TileBenchmark benchmark(region, TilePos(0, 0, 0));
+	benchmark.setIterations(iterations);
+
+	std::vector<Result> results;
+	benchmark.runAll(results);
+	print(results, out);
+}
+
+void TileBenchmark::print(const std::vector<Result>& results, FILE* out)
+{
+	fprintf(out, "preset\tcase\tops\tns/op\tallocs/op\tmisses/op\tskipped/op\n");
+	for(const Result& result : results)
+	{
+		fprintf(out, "%s\t%s\t%llu\t%.2f\t%.3f\t%.3f\t%.3f\n", getPresetName(result.preset), result.name.c_str(),
+			(unsigned long long) result.ops, result.nsPerOp, result.allocationsPerOp, result.cacheMissesPerOp, result.skippedPerOp);
+	}
+}
+
+#ifdef TILE_BENCHMARK_MAIN
+/* tilebench [iterations] */
+int main(int argc, char** argv)
+{
+	Tile::initTiles();
+	TileBenchmark::runHeadless(stdout, argc > 1? atoi(argv[1]) : 20);
+	Tile::teardownTiles();
+	return 0;
+}
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/* Timings for the Tile hot paths over generated terrain
+	Each preset (plains, forest, cave, redstone) is generated into an in-memory box of
+	IDs, written into the TileSource the benchmark was given, and every case
+	then runs over the same positions: ns/op from steady_clock, allocations per op when
+	built with TILE_BENCHMARK_COUNT_ALLOCATIONS (which replaces the global operator new),
+	and cache misses per op from perf events on Linux, -1 where they aren't available.
+	Nothing here draws or needs a window, so it runs on a headless box: runHeadless()
+	builds its own TileSource over blank in-memory chunks with no Level behind it, and
+	building with TILE_BENCHMARK_MAIN adds a main() that prints its table to stdout.
+*/
+class TileBenchmark
+{
+public:
+	enum Preset
+	{
+		PLAINS,
+		FOREST,
+		CAVE,
+		REDSTONE,
+		PRESET_COUNT
+	};
+
+	struct Terrain
+	{
+		int width, height, depth;
+		std::vector<TileID> ids;
+
+		int index(int x, int y, int z) const { return (y * depth + z) * width + x; }
+		TileID getId(int x, int y, int z) const { return ids[index(x, y, z)]; }
+		void set(int x, int y, int z, Tile*);
+	};
+
+	struct Result
+	{
+		std::string name;
+		Preset preset;
+		uint64_t ops;
+		double nsPerOp;
+		double allocationsPerOp; // -1 without TILE_BENCHMARK_COUNT_ALLOCATIONS
+		double cacheMissesPerOp; // -1 without perf events
+		double skippedPerOp; // capability cases, share of dispatches TileCapabilities saves; -1 otherwise
+	};
+
+	static const int WIDTH = 48;
+	static const int HEIGHT = 64;
+
+	/* With a player getDestroyProgress goes through it, without one the same math runs on
+		fixed tool inputs (bare hand, a tool that can't harvest, a fast pickaxe)
+	*/
+	TileBenchmark(TileSource& region, const TilePos& origin, Player* player = NULL);
+
+	void setIterations(int);
+	void setSeed(uint32_t seed) { this->seed = seed; }
+
+	static void generate(Preset, uint32_t seed, Terrain&);
+	/* Writes the terrain into region without neighbour updates, origin is the lowest corner */
+	static void apply(const Terrain&, TileSource& region, const TilePos& origin);
+
+	void run(Preset, std::vector<Result>&);
+	void runAll(std::vector<Result>&);
+	/* Every preset over an in-memory TileSource, after Tile::initTiles; no Player, so getDestroyProgress uses the tool inputs */
+	static void runHeadless(FILE* out, int iterations = 20);
+
+	static const char* getPresetName(Preset);
+	/* One line per result, columns separated by tabs for diffing between builds */
+	static void print(const std::vector<Result>&, FILE*);
+
+	static uint64_t getAllocationCount();
+
+private:
+	TileSource& region;
+	TilePos origin;
+	Player* player;
+	int iterations;
+	uint32_t seed;
+
+	template<typename Body>
+	Result _measure(const char* name, Preset, uint64_t opsPerIteration, Body);
+};
@@ -0,0 +1,101 @@
+#include "TileCapabilities.h"
+
+#include <cstring>
+#include <typeinfo>
+
+#include "Tile.h"
+
+uint32_t TileCapabilities::caps[256];
+uint32_t TileCapabilities::declared[256];
+bool TileCapabilities::declaredAny[256];
+const std::type_info* TileCapabilities::declaredBy[256];
+std::atomic<uint64_t> TileCapabilities::skipped[HOOK_COUNT];
+
+void TileCapabilities::declare(TileID blockId, uint32_t hooks, const std::type_info& declaringClass)
+{
+	declared[blockId] |= hooks & ALL;
+	declaredAny[blockId] = true;
+	declaredBy[blockId] = &declaringClass;
+}
+
+void TileCapabilities::reset(TileID blockId)
+{
+	declared[blockId] = 0;
+	declaredAny[blockId] = false;
+	declaredBy[blockId] = NULL;
+}
+
+/* Needs the finished object, typeid is only the subclass once its constructor has run */
+void TileCapabilities::update(const Tile& tile)
+{
+	TileID blockId = tile.blockId;
+	if(typeid(tile) == typeid(Tile))
+	{
+		caps[blockId] = 0;
+	}
+	else if(declaredAny[blockId] && *declaredBy[blockId] == typeid(tile))
+	{
+		caps[blockId] = declared[blockId];
+	}
+	else
+	{
+		caps[blockId] = ALL;
+	}
+}
+
+void TileCapabilities::clear(TileID blockId)
+{
+	caps[blockId] = 0;
+	reset(blockId);
+}
+
+void TileCapabilities::clearAll()
+{
+	memset(caps, 0, sizeof(caps));
+	memset(declared, 0, sizeof(declared));
+	memset(declaredAny, 0, sizeof(declaredAny));
+	memset(declaredBy, 0, sizeof(declaredBy));
+}
+
+int TileCapabilities::hookIndex(Hook hook)
+{
+	int index = 0;
+	while(((uint32_t) hook >> index) > 1)
+	{
+		index++;
+	}
+
+	return index;
+}
+
+void TileCapabilities::addSkipped(Hook hook, uint32_t count)
+{
+	if(count)
+	{
+		skipped[hookIndex(hook)].fetch_add(count, std::memory_order_relaxed);
+	}
+}
+
+uint64_t TileCapabilities::getSkipped(Hook hook)
+{
+	return skipped[hookIndex(hook)].load(std::memory_order_relaxed);
+}
+
+uint64_t TileCapabilities::getTotalSkipped()
+{
+	uint64_t total = 0;
+	for(int i = 0; i < HOOK_COUNT; i++)
+	{
+		total += skipped[i].load(std::memory_order_relaxed);
+	}
+
+	return total;
+}
+
+void TileCapabilities::resetSkipped()
+{
+	for(int i = 0; i < HOOK_COUNT; i++)
+	{
+		skipped[i].store(0, std::memory_order_relaxed);
+	}
+}
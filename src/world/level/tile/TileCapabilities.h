@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <typeinfo>
+
+class Tile;
+
+/* Which of the no-op Tile hooks a tile actually overrides
+	Every Tile subclass declares the hooks it overrides from its constructor,
+		TileCapabilities::declare(this, TileCapabilities::TICK | TileCapabilities::NEIGHBOR_CHANGED);
+	and a subclass of a subclass adds its own on top, the constructors run base first.
+	declare() also records the class it was called from. update() turns that into the row
+	dispatch loops test instead of making a virtual call into an empty body: a plain Tile
+	has no bits, a class that declared itself has what it and its bases declared, and a
+	class that didn't keeps every bit, even when a base declared, since it may override
+	hooks its base doesn't. Nothing is ever skipped that shouldn't be. The WORLD_ bits cover the position overloads of getShape,
+	getTexture, getColor and getAABB, whose base versions only forward to the data ones;
+	TileStateTable and TileShapeCache use them to tell which tiles depend on more than
+	their data, and NavGrid does the same with PATHFINDABLE for isPathfindable.
+*/
+class TileCapabilities
+{
+public:
+	enum Hook : uint32_t
+	{
+		TICK = 1 << 0,
+		ANIMATE_TICK = 1 << 1,
+		NEIGHBOR_CHANGED = 1 << 2,
+		ON_PLACE = 1 << 3,
+		ON_REMOVE = 1 << 4,
+		STEP_ON = 1 << 5,
+		FALL_ON = 1 << 6,
+		HANDLE_ENTITY_INSIDE = 1 << 7,
+		ENTITY_INSIDE = 1 << 8,
+		WORLD_SHAPE = 1 << 9,
+		WORLD_TEXTURE = 1 << 10,
+		WORLD_COLOR = 1 << 11,
+		PATHFINDABLE = 1 << 12,
+		SHOULD_RENDER_FACE = 1 << 13,
+		WORLD_AABB = 1 << 14,
+		ADD_AABBS = 1 << 15,
+		DESCRIPTION_ID = 1 << 16
+	};
+
+	static const int HOOK_COUNT = 17;
+	static const uint32_t ALL = (1u << HOOK_COUNT) - 1;
+
+	/* From a subclass constructor as declare(this, hooks), ORs hooks into what the tile
+		declared so far and marks T as the class that declared last
+	*/
+	template<typename T>
+	static void declare(const T* tile, uint32_t hooks) { declare(tile->blockId, hooks, typeid(T)); }
+	static void declare(TileID blockId, uint32_t hooks, const std::type_info& declaringClass);
+	/* Called by the Tile constructor, a new tile starts with nothing declared */
+	static void reset(TileID blockId);
+
+	static void update(const Tile&);
+	static void clear(TileID blockId);
+	static void clearAll();
+
+	static uint32_t get(TileID blockId) { return caps[blockId]; }
+	static bool has(TileID blockId, Hook hook) { return (caps[blockId] & hook) != 0; }
+	static bool isDeclared(TileID blockId) { return declaredAny[blockId]; }
+
+	/* Calls the loops didn't make, added once per loop rather than per skip */
+	static void addSkipped(Hook, uint32_t count);
+	static uint64_t getSkipped(Hook);
+	static uint64_t getTotalSkipped();
+	static void resetSkipped();
+
+	static int hookIndex(Hook);
+
+private:
+	static uint32_t caps[256];
+	static uint32_t declared[256];
+	static bool declaredAny[256];
+	static const std::type_info* declaredBy[256]; // the most derived class that called declare()
+	static std::atomic<uint64_t> skipped[HOOK_COUNT];
+};
@@ -0,0 +1,329 @@
+#include "TileHookProfiler.h"
+
+#include <cstring>
+
+#include "Tile.h"
+#include "TileNameTable.h"
+
+struct TileHookProfiler::LocalCounter
+{
+	std::atomic<uint64_t> calls;
+	std::atomic<uint64_t> nanos;
+	std::atomic<uint64_t> selfNanos;
+};
+
+struct TileHookProfiler::ThreadTable
+{
+	LocalCounter counters[256][HOOK_COUNT];
+	bool live;
+
+	ThreadTable()
+	{
+		live = false;
+		clear();
+	}
+
+	void clear()
+	{
+		for(int id = 0; id < 256; id++)
+		{
+			for(int hook = 0; hook < HOOK_COUNT; hook++)
+			{
+				counters[id][hook].calls.store(0, std::memory_order_relaxed);
+				counters[id][hook].nanos.store(0, std::memory_order_relaxed);
+				counters[id][hook].selfNanos.store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+};
+
+/* Hands the thread's table back when the thread exits */
+struct TileHookProfiler::TableHolder
+{
+	ThreadTable* table;
+
+	TableHolder()
+	{
+		table = NULL;
+	}
+
+	~TableHolder()
+	{
+		if(table)
+		{
+			_retire(table);
+		}
+	}
+};
+
+std::atomic<bool> TileHookProfiler::enabled(false);
+std::mutex TileHookProfiler::tablesMutex;
+std::vector<std::unique_ptr<TileHookProfiler::ThreadTable>> TileHookProfiler::tables;
+std::vector<TileHookProfiler::ThreadTable*> TileHookProfiler::freeTables;
+TileHookProfiler::Counter TileHookProfiler::retired[256][TileHookProfiler::HOOK_COUNT];
+std::deque<TileHookProfiler::Snapshot> TileHookProfiler::history;
+TileHookProfiler::Snapshot TileHookProfiler::lastSnapshot;
+uint64_t TileHookProfiler::tickCount = 0;
+uint64_t TileHookProfiler::lastSnapshotTick = 0;
+int TileHookProfiler::snapshotInterval = 20;
+
+thread_local TileHookProfiler::TableHolder TileHookProfiler::localTable;
+thread_local TileHookProfiler::Scope* TileHookProfiler::currentScope = NULL;
+
+static const char* HOOK_NAMES[TileHookProfiler::HOOK_COUNT] = {
+	"tick", "neighborChanged", "onPlace", "onRemove", "entityInside", "use", "getSignal"
+};
+
+void TileHookProfiler::Snapshot::clear()
+{
+	tick = 0;
+	ticks = 0;
+	memset(counters, 0, sizeof(counters));
+}
+
+TileHookProfiler::Snapshot TileHookProfiler::Snapshot::since(const Snapshot& earlier) const
+{
+	Snapshot delta;
+	delta.tick = tick;
+	delta.ticks = tick - earlier.tick;
+	for(int id = 0; id < 256; id++)
+	{
+		for(int hook = 0; hook < HOOK_COUNT; hook++)
+		{
+			delta.counters[id][hook].calls = counters[id][hook].calls - earlier.counters[id][hook].calls;
+			delta.counters[id][hook].nanos = counters[id][hook].nanos - earlier.counters[id][hook].nanos;
+			delta.counters[id][hook].selfNanos = counters[id][hook].selfNanos - earlier.counters[id][hook].selfNanos;
+		}
+	}
+
+	return delta;
+}
+
+TileHookProfiler::Counter TileHookProfiler::Snapshot::getTotal(Hook hook) const
+{
+	Counter total = {0, 0, 0};
+	for(int id = 0; id < 256; id++)
+	{
+		total.calls += counters[id][hook].calls;
+		total.nanos += counters[id][hook].nanos;
+		total.selfNanos += counters[id][hook].selfNanos;
+	}
+
+	return total;
+}
+
+void TileHookProfiler::setEnabled(bool _enabled)
+{
+	enabled.store(_enabled, std::memory_order_relaxed);
+}
+
+void TileHookProfiler::setSnapshotInterval(int ticks)
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	snapshotInterval = ticks > 0? ticks : 0;
+}
+
+TileHookProfiler::LocalCounter* TileHookProfiler::_local(TileID blockId, Hook hook)
+{
+	if(!localTable.table)
+	{
+		std::lock_guard<std::mutex> lock(tablesMutex);
+		if(freeTables.empty())
+		{
+			tables.push_back(std::unique_ptr<ThreadTable>(new ThreadTable()));
+			localTable.table = tables.back().get();
+		}
+		else
+		{
+			localTable.table = freeTables.back();
+			freeTables.pop_back();
+		}
+		localTable.table->live = true;
+	}
+
+	return &localTable.table->counters[blockId][hook];
+}
+
+/* only the owning thread writes its table, a plain load and store is enough */
+void TileHookProfiler::_add(LocalCounter* counter, uint64_t nanos, uint64_t selfNanos)
+{
+	counter->calls.store(counter->calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	counter->nanos.store(counter->nanos.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+	counter->selfNanos.store(counter->selfNanos.load(std::memory_order_relaxed) + selfNanos, std::memory_order_relaxed);
+}
+
+/* The exiting thread's counts move into retired under the lock, so snapshots never see them twice or not at all */
+void TileHookProfiler::_retire(ThreadTable* table)
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	for(int id = 0; id < 256; id++)
+	{
+		for(int hook = 0; hook < HOOK_COUNT; hook++)
+		{
+			retired[id][hook].calls += table->counters[id][hook].calls.load(std::memory_order_relaxed);
+			retired[id][hook].nanos += table->counters[id][hook].nanos.load(std::memory_order_relaxed);
+			retired[id][hook].selfNanos += table->counters[id][hook].selfNanos.load(std::memory_order_relaxed);
+		}
+	}
+
+	table->clear();
+	table->live = false;
+	freeTables.push_back(table);
+}
+
+void TileHookProfiler::snapshot(Snapshot& out)
+{
+	out.clear();
+
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	out.tick = tickCount;
+	out.ticks = tickCount;
+	memcpy(out.counters, retired, sizeof(retired));
+	for(const std::unique_ptr<ThreadTable>& table : tables)
+	{
+		if(!table->live)
+		{
+			continue;
+		}
+
+		for(int id = 0; id < 256; id++)
+		{
+			for(int hook = 0; hook < HOOK_COUNT; hook++)
+			{
+				out.counters[id][hook].calls += table->counters[id][hook].calls.load(std::memory_order_relaxed);
+				out.counters[id][hook].nanos += table->counters[id][hook].nanos.load(std::memory_order_relaxed);
+				out.counters[id][hook].selfNanos += table->counters[id][hook].selfNanos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+}
+
+void TileHookProfiler::onTick()
+{
+	if(!isEnabled())
+	{
+		return;
+	}
+
+	uint64_t ticksSince;
+	{
+		std::lock_guard<std::mutex> lock(tablesMutex);
+		tickCount++;
+		ticksSince = tickCount - lastSnapshotTick;
+		if(!snapshotInterval || ticksSince < (uint64_t) snapshotInterval)
+		{
+			return;
+		}
+	}
+
+	/* 42KB each, kept off the stack of whatever thread drives the level */
+	std::unique_ptr<Snapshot> now(new Snapshot());
+	snapshot(*now);
+
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	history.push_back(now->since(lastSnapshot));
+	history.back().ticks = ticksSince;
+	if((int) history.size() > HISTORY)
+	{
+		history.pop_front();
+	}
+
+	lastSnapshot = *now;
+	lastSnapshotTick = now->tick;
+}
+
+std::vector<TileHookProfiler::Snapshot> TileHookProfiler::getHistory()
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	return std::vector<Snapshot>(history.begin(), history.end());
+}
+
+/* a thread mid-hook may still land its last call on the old count, reset between ticks */
+void TileHookProfiler::reset()
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	for(const std::unique_ptr<ThreadTable>& table : tables)
+	{
+		table->clear();
+	}
+	memset(retired, 0, sizeof(retired));
+
+	history.clear();
+	lastSnapshot.clear();
+	lastSnapshot.tick = tickCount;
+	lastSnapshotTick = tickCount;
+}
+
+const char* TileHookProfiler::getHookName(Hook hook)
+{
+	return HOOK_NAMES[hook];
+}
+
+void TileHookProfiler::_writeTileName(TileID blockId, FILE* out)
+{
+	const std::string& name = TileNameTable::getDescriptionId(blockId);
+	if(name.empty())
+	{
+		fprintf(out, "tile_%d", blockId);
+	}
+	else
+	{
+		fputs(name.c_str(), out);
+	}
+}
+
+void TileHookProfiler::writeFolded(const Snapshot& snapshot, FILE* out)
+{
+	for(int id = 0; id < 256; id++)
+	{
+		for(int hook = 0; hook < HOOK_COUNT; hook++)
+		{
+			const Counter& counter = snapshot.counters[id][hook];
+			if(!counter.calls)
+			{
+				continue;
+			}
+
+			fputs("level;", out);
+			_writeTileName(id, out);
+			fprintf(out, ";%s %llu\n", HOOK_NAMES[hook], (unsigned long long) counter.selfNanos);
+		}
+	}
+}
+
+void TileHookProfiler::writeJson(const Snapshot& snapshot, FILE* out)
+{
+	fprintf(out, "{\"tick\":%llu,\"ticks\":%llu,\"tiles\":[", (unsigned long long) snapshot.tick, (unsigned long long) snapshot.ticks);
+
+	bool firstTile = true;
+	for(int id = 0; id < 256; id++)
+	{
+		bool firstHook = true;
+		for(int hook = 0; hook < HOOK_COUNT; hook++)
+		{
+			const Counter& counter = snapshot.counters[id][hook];
+			if(!counter.calls)
+			{
+				continue;
+			}
+
+			if(firstHook)
+			{
+				fprintf(out, "%s{\"id\":%d,\"name\":\"", firstTile? "" : ",", id);
+				_writeTileName(id, out);
+				fputs("\",\"hooks\":{", out);
+				firstTile = false;
+			}
+			fprintf(out, "%s\"%s\":{\"calls\":%llu,\"ns\":%llu,\"selfNs\":%llu}", firstHook? "" : ",", HOOK_NAMES[hook],
+				(unsigned long long) counter.calls, (unsigned long long) counter.nanos, (unsigned long long) counter.selfNanos);
+			firstHook = false;
+		}
+
+		if(!firstHook)
+		{
+			fputs("}}", out);
+		}
+	}
+
+	fputs("]}\n", out);
+}
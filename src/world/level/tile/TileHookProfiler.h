@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* Calls and time per tile ID for the Tile hooks the level dispatches
+	Each thread adds into its own table of relaxed atomics, loaded and stored by that
+	thread only, so the hot path has no lock or locked instruction. When a thread exits
+	its table is folded into a shared total and goes on a free list for the next thread,
+	and snapshot() sums the live tables and that total. Call onTick() once per level
+	tick and every interval ticks the delta since the previous one joins a short
+	history, which exports as folded stacks for flamegraph.pl or as JSON.
+	Hooks run inside other hooks (a neighborChanged asking getSignal), so every call
+	records both its inclusive time and its self time, without the hooks timed under
+	it. JSON carries both; the folded export has no call paths to nest them under and
+	writes self time, so a nested call's time is counted once, as its own sibling line.
+	Dispatch sites use TILE_HOOK_SCOPE, which is empty unless built with TILE_HOOK_PROFILING;
+	compiled in but disabled it costs one relaxed load and a branch per call.
+*/
+class TileHookProfiler
+{
+	struct LocalCounter;
+	struct ThreadTable;
+	struct TableHolder;
+
+public:
+	enum Hook
+	{
+		TICK,
+		NEIGHBOR_CHANGED,
+		ON_PLACE,
+		ON_REMOVE,
+		ENTITY_INSIDE,
+		USE,
+		GET_SIGNAL,
+		HOOK_COUNT
+	};
+
+	struct Counter
+	{
+		uint64_t calls;
+		uint64_t nanos; // inclusive
+		uint64_t selfNanos; // without the hooks timed inside this one
+	};
+
+	struct Snapshot
+	{
+		uint64_t tick; // onTick() count when it was taken
+		uint64_t ticks; // level ticks it covers
+		Counter counters[256][HOOK_COUNT];
+
+		void clear();
+		/* This snapshot minus an earlier one */
+		Snapshot since(const Snapshot&) const;
+		Counter getTotal(Hook) const;
+	};
+
+	/* Times one hook call on the current thread, nothing happens while disabled */
+	class Scope
+	{
+	public:
+		Scope(TileID blockId, Hook hook)
+		{
+			counter = enabled.load(std::memory_order_relaxed)? _local(blockId, hook) : NULL;
+			if(counter)
+			{
+				parent = currentScope;
+				currentScope = this;
+				childNanos = 0;
+				start = std::chrono::steady_clock::now();
+			}
+		}
+
+		~Scope()
+		{
+			if(counter)
+			{
+				uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+				currentScope = parent;
+				if(parent)
+				{
+					parent->childNanos += nanos;
+				}
+				_add(counter, nanos, nanos > childNanos? nanos - childNanos : 0);
+			}
+		}
+
+	private:
+		LocalCounter* counter;
+		Scope* parent;
+		uint64_t childNanos;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	static const int HISTORY = 64;
+
+	static void setEnabled(bool);
+	static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+	/* Level ticks between history snapshots, 0 stops taking them */
+	static void setSnapshotInterval(int ticks);
+
+	static void onTick();
+	static void snapshot(Snapshot&);
+	/* Oldest first, each entry is the delta over its interval */
+	static std::vector<Snapshot> getHistory();
+	/* Zeroes every thread's table and drops the history */
+	static void reset();
+
+	static const char* getHookName(Hook);
+	/* "level;<tile>;<hook> <self ns>" per line, the input flamegraph.pl expects */
+	static void writeFolded(const Snapshot&, FILE*);
+	static void writeJson(const Snapshot&, FILE*);
+
+private:
+	static std::atomic<bool> enabled;
+	static std::mutex tablesMutex;
+	static std::vector<std::unique_ptr<ThreadTable>> tables;
+	static std::vector<ThreadTable*> freeTables;
+	static Counter retired[256][HOOK_COUNT]; // folded in from threads that have exited
+	static thread_local TableHolder localTable;
+	static thread_local Scope* currentScope;
+	static std::deque<Snapshot> history;
+	static Snapshot lastSnapshot;
+	static uint64_t tickCount;
+	static uint64_t lastSnapshotTick;
+	static int snapshotInterval;
+
+	static LocalCounter* _local(TileID, Hook);
+	static void _add(LocalCounter*, uint64_t nanos, uint64_t selfNanos);
+	static void _retire(ThreadTable*);
+	static void _writeTileName(TileID, FILE*);
+};
+
+#ifdef TILE_HOOK_PROFILING
+#define TILE_HOOK_SCOPE(blockId, hook) TileHookProfiler::Scope _tileHookScope((blockId), TileHookProfiler::hook)
+#else
+#define TILE_HOOK_SCOPE(blockId, hook)
+#endif
@@ -0,0 +1,174 @@
+#include "TileNameIndex.h"
+#include "Tile.h"
+
+TileNameIndex::Slot TileNameIndex::slots[TileNameIndex::SLOT_COUNT];
+int16_t TileNameIndex::slotOf[256];
+std::string TileNameIndex::keys[256];
+bool TileNameIndex::initialized = false;
+
+static inline char _lower(char c)
+{
+	return (c >= 'A' && c <= 'Z')? (c + ('a' - 'A')) : c;
+}
+
+void TileNameIndex::_init()
+{
+	for(Slot& slot : slots)
+	{
+		slot.hash = 0;
+		slot.blockId = EMPTY;
+	}
+	for(int i = 0; i < 256; i++)
+	{
+		slotOf[i] = EMPTY;
+		keys[i].clear();
+	}
+	initialized = true;
+}
+
+/* FNV-1a over the lower-cased name */
+uint32_t TileNameIndex::_hash(const char* name, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for(size_t i = 0; i < length; i++)
+	{
+		hash ^= (uint8_t) _lower(name[i]);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+bool TileNameIndex::_equals(const std::string& key, const char* name, size_t length)
+{
+	if(key.size() != length)
+	{
+		return false;
+	}
+	for(size_t i = 0; i < length; i++)
+	{
+		if(key[i] != _lower(name[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* (Re)indexes the tile under its current description ID
+	Called on registration and whenever the description ID changes, the old key is dropped
+*/
+void TileNameIndex::add(const Tile& tile)
+{
+	if(!initialized)
+	{
+		_init();
+	}
+
+	TileID blockId = tile.blockId;
+	remove(blockId);
+
+	std::string name = tile.getDescriptionId();
+	if(name.empty() || Tile::tiles[blockId] != &tile)
+	{
+		return;
+	}
+
+	std::string& key = keys[blockId];
+	key.resize(name.size());
+	for(size_t i = 0; i < name.size(); i++)
+	{
+		key[i] = _lower(name[i]);
+	}
+
+	uint32_t hash = _hash(name.data(), name.size());
+	int index = hash & (SLOT_COUNT - 1);
+	while(slots[index].blockId >= 0)
+	{
+		index = (index + 1) & (SLOT_COUNT - 1);
+	}
+
+	slots[index].hash = hash;
+	slots[index].blockId = blockId;
+	slotOf[blockId] = index;
+}
+
+void TileNameIndex::remove(TileID blockId)
+{
+	if(!initialized || slotOf[blockId] == EMPTY)
+	{
+		return;
+	}
+
+	slots[slotOf[blockId]].blockId = REMOVED;
+	slotOf[blockId] = EMPTY;
+	keys[blockId].clear();
+}
+
+void TileNameIndex::clear()
+{
+	_init();
+}
+
+void TileNameIndex::rebuild()
+{
+	_init();
+	for(int i = 0; i < 256; i++)
+	{
+		if(Tile::tiles[i])
+		{
+			add(*Tile::tiles[i]);
+		}
+	}
+}
+
+int TileNameIndex::find(const std::string& name)
+{
+	return find(name.data(), name.size());
+}
+
+int TileNameIndex::find(const char* name, size_t length)
+{
+	if(!initialized)
+	{
+		return NOT_FOUND;
+	}
+
+	/* the whole probe run is checked, duplicates resolve to the lowest ID */
+	uint32_t hash = _hash(name, length);
+	int index = hash & (SLOT_COUNT - 1);
+	int found = NOT_FOUND;
+	for(int probes = 0; probes < SLOT_COUNT; probes++)
+	{
+		const Slot& slot = slots[index];
+		if(slot.blockId == EMPTY)
+		{
+			break;
+		}
+		if(slot.blockId >= 0 && (found == NOT_FOUND || slot.blockId < found) && slot.hash == hash && _equals(keys[slot.blockId], name, length))
+		{
+			found = slot.blockId;
+		}
+		index = (index + 1) & (SLOT_COUNT - 1);
+	}
+
+	return found;
+}
+
+void TileNameIndex::findAll(const std::vector<std::string>& names, std::vector<int>& out)
+{
+	out.resize(names.size());
+	if(!names.empty())
+	{
+		findAll(names.data(), names.size(), out.data());
+	}
+}
+
+void TileNameIndex::findAll(const std::string* names, int count, int* out)
+{
+	for(int i = 0; i < count; i++)
+	{
+		out[i] = find(names[i]);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Tile;
+
+/* Case-insensitive description ID -> block ID index
+	Filled from Tile::init() and Tile::setDescriptionId(), so lookups never walk Tile::tiles[]
+	and never allocate; keys are stored lower-cased and compared char by char. Keys come
+	from the virtual getDescriptionId(), which only reaches overrides once the subclass is
+	constructed, so initTiles() rebuilds the index after every tile exists. Like the old
+	loop over Tile::tiles[], a name shared by several tiles finds the lowest ID.
+*/
+class TileNameIndex
+{
+public:
+	static const int NOT_FOUND = -1;
+
+	static void add(const Tile&);
+	static void remove(TileID);
+	static void clear();
+	/* Re-keys every registered tile, after all constructors have run */
+	static void rebuild();
+
+	static int find(const std::string&);
+	static int find(const char*, size_t);
+	/* Resolves every name in one pass, out receives NOT_FOUND for unknown names */
+	static void findAll(const std::vector<std::string>&, std::vector<int>&);
+	static void findAll(const std::string*, int, int*);
+
+private:
+	static const int SLOT_COUNT = 512; // power of two, twice the ID space
+	static const int16_t EMPTY = -1;
+	static const int16_t REMOVED = -2;
+
+	struct Slot
+	{
+		uint32_t hash;
+		int16_t blockId;
+	};
+
+	static Slot slots[SLOT_COUNT];
+	static int16_t slotOf[256];
+	static std::string keys[256];
+	static bool initialized;
+
+	static void _init();
+	static uint32_t _hash(const char*, size_t);
+	static bool _equals(const std::string&, const char*, size_t);
+};
@@ -0,0 +1,77 @@
+#include "TileNameTable.h"
+
+#include <cstring>
+
+std::string TileNameTable::descriptionIds[256];
+std::string TileNameTable::nameKeys[256];
+std::unordered_map<std::string, std::unique_ptr<TileNameTable::LocaleTable>> TileNameTable::locales;
+std::atomic<TileNameTable::LocaleTable*> TileNameTable::current(NULL);
+std::string TileNameTable::locale;
+
+TileNameTable::LocaleTable& TileNameTable::_getTable(const std::string& code)
+{
+	std::unique_ptr<LocaleTable>& table = locales[code];
+	if(!table)
+	{
+		table.reset(new LocaleTable());
+		memset(table->cached, 0, sizeof(table->cached));
+	}
+
+	return *table;
+}
+
+void TileNameTable::_translate(LocaleTable& table, TileID blockId)
+{
+	table.names[blockId] = I18n::get(nameKeys[blockId]);
+	table.cached[blockId] = true;
+}
+
+void TileNameTable::setDescriptionId(TileID blockId, const std::string& descriptionId)
+{
+	descriptionIds[blockId] = descriptionId;
+	nameKeys[blockId] = descriptionId + ".name";
+
+	/* every other locale translated the old key, they catch up when switched back to */
+	LocaleTable& table = _getTable(locale);
+	for(auto& entry : locales)
+	{
+		entry.second->cached[blockId] = false;
+	}
+	_translate(table, blockId);
+	current.store(&table, std::memory_order_release);
+}
+
+const std::string& TileNameTable::getLocalizedName(TileID blockId)
+{
+	static const std::string empty;
+
+	LocaleTable* table = current.load(std::memory_order_acquire);
+	return table? table->names[blockId] : empty;
+}
+
+void TileNameTable::setLocale(const std::string& code)
+{
+	LocaleTable& table = _getTable(code);
+	for(int i = 0; i < 256; i++)
+	{
+		if(!nameKeys[i].empty() && !table.cached[i])
+		{
+			_translate(table, i);
+		}
+	}
+
+	locale = code;
+	current.store(&table, std::memory_order_release);
+}
+
+void TileNameTable::clear()
+{
+	for(int i = 0; i < 256; i++)
+	{
+		descriptionIds[i].clear();
+		nameKeys[i].clear();
+	}
+
+	current.store(NULL, std::memory_order_release);
+	locales.clear();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/* Interned description IDs and localised names per tile ID
+	setDescriptionId() stores "tile.<id>" and "tile.<id>.name" once, and the I18n result
+	is cached per locale, so the name and tooltip paths return references into these
+	tables instead of concatenating and hashing on every call. Switching back to a locale
+	used before reuses its table.
+	Names are translated when they are registered and when the locale changes, never on
+	lookup, so getLocalizedName() only reads and mesher or UI threads can call it freely.
+	setLocale() fills the new table before publishing it; it and setDescriptionId() run
+	on the main thread.
+*/
+class TileNameTable
+{
+public:
+	/* Stores the full description ID, e.g. "tile.stone" */
+	static void setDescriptionId(TileID blockId, const std::string& descriptionId);
+	static const std::string& getDescriptionId(TileID blockId) { return descriptionIds[blockId]; }
+	static const std::string& getNameKey(TileID blockId) { return nameKeys[blockId]; }
+
+	/* I18n::get(getNameKey()) for the current locale */
+	static const std::string& getLocalizedName(TileID blockId);
+
+	/* Call after I18n switched language, translates every registered ID up front */
+	static void setLocale(const std::string& locale);
+	static const std::string& getLocale() { return locale; }
+	static void clear();
+
+private:
+	struct LocaleTable
+	{
+		std::string names[256];
+		bool cached[256];
+	};
+
+	static std::string descriptionIds[256];
+	static std::string nameKeys[256];
+	static std::unordered_map<std::string, std::unique_ptr<LocaleTable>> locales;
+	static std::atomic<LocaleTable*> current;
+	static std::string locale;
+
+	static LocaleTable& _getTable(const std::string&);
+	static void _translate(LocaleTable&, TileID);
+};
@@ -0,0 +1,120 @@
+#include "TileProperties.h"
+#include "Tile.h"
+
+TileProperties::Table TileProperties::table;
+
+/* Rebuilds the row for this tile from the static arrays and its Material */
+void TileProperties::update(const Tile& tile)
+{
+	TileID blockId = tile.blockId;
+	uint8_t flags = 0;
+
+	if(Tile::tiles[blockId] == &tile)
+	{
+		flags |= REGISTERED;
+	}
+	if(Tile::solid[blockId])
+	{
+		flags |= SOLID;
+	}
+	if(Tile::shouldTick[blockId])
+	{
+		flags |= TICKS;
+	}
+	if(Tile::lightEmission[blockId] > 0)
+	{
+		flags |= EMITS_LIGHT;
+	}
+	if(tile.material)
+	{
+		if(tile.isLiquidTile())
+		{
+			flags |= LIQUID;
+		}
+		if(tile.material->blocksMotion)
+		{
+			flags |= BLOCKS_MOTION;
+		}
+		if(tile.material->replaceable)
+		{
+			flags |= REPLACEABLE;
+		}
+	}
+
+	table.flags[blockId] = flags;
+	table.lightBlock[blockId] = (uint8_t) Tile::lightBlock[blockId];
+	table.lightEmission[blockId] = (uint8_t) Tile::lightEmission[blockId];
+	table.translucency[blockId] = Tile::translucency[blockId];
+	table.explosionResistance[blockId] = tile.explosionResistance * 0.2F;
+
+	for(int i = 0; i < FLAG_COUNT; i++)
+	{
+		_setBit(i, blockId, (flags & (1 << i)) != 0);
+	}
+}
+
+void TileProperties::clear(TileID blockId)
+{
+	table.flags[blockId] = 0;
+	table.lightBlock[blockId] = 0;
+	table.lightEmission[blockId] = 0;
+	table.translucency[blockId] = 0.0F;
+	table.explosionResistance[blockId] = 0.0F;
+
+	for(int i = 0; i < FLAG_COUNT; i++)
+	{
+		_setBit(i, blockId, false);
+	}
+}
+
+void TileProperties::clearAll()
+{
+	for(int i = 0; i < 256; i++)
+	{
+		clear(i);
+	}
+}
+
+const uint32_t* TileProperties::getBits(Flag flag)
+{
+	return table.bits[_flagIndex(flag)];
+}
+
+uint32_t TileProperties::gather(const TileID* ids, int count, Flag flag)
+{
+	const uint32_t* bits = table.bits[_flagIndex(flag)];
+	uint32_t mask = 0;
+	for(int i = 0; i < count; i++)
+	{
+		TileID blockId = ids[i];
+		mask |= ((bits[blockId >> 5] >> (blockId & 31)) & 1) << i;
+	}
+
+	return mask;
+}
+
+void TileProperties::gatherFlags(const TileID* ids, int count, uint8_t* out)
+{
+	for(int i = 0; i < count; i++)
+	{
+		out[i] = table.flags[ids[i]];
+	}
+}
+
+int TileProperties::_flagIndex(Flag flag)
+{
+	int index = 0;
+	while(((uint32_t) flag >> index) > 1)
+	{
+		index++;
+	}
+
+	return index;
+}
+
+void TileProperties::_setBit(int flagIndex, TileID blockId, bool set)
+{
+	uint32_t& word = table.bits[flagIndex][blockId >> 5];
+	uint32_t bit = 1u << (blockId & 31);
+	word = set? (word | bit) : (word & ~bit);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+class Tile;
+
+/* Packed, per-ID copy of Tile::solid[], lightBlock[], lightEmission[], shouldTick[]
+	and of the Material flags the hot paths keep asking for.
+	Rows are written from Tile::init() and from the setters that touch the static arrays,
+	so every query is a plain table read with no virtual call or Material* load.
+*/
+class TileProperties
+{
+public:
+	enum Flag : uint8_t
+	{
+		SOLID = 1 << 0,
+		TICKS = 1 << 1,
+		LIQUID = 1 << 2,
+		BLOCKS_MOTION = 1 << 3,
+		REPLACEABLE = 1 << 4,
+		EMITS_LIGHT = 1 << 5,
+		REGISTERED = 1 << 6
+	};
+
+	static const int FLAG_COUNT = 7;
+
+	/* 256 flag bytes followed by the small lookup arrays, one cache line per 64 IDs */
+	struct alignas(64) Table
+	{
+		uint8_t flags[256];
+		uint8_t lightBlock[256];
+		uint8_t lightEmission[256];
+		float translucency[256];
+		float explosionResistance[256]; // Tile::explosionResistance * 0.2, as getExplosionResistance
+		uint32_t bits[FLAG_COUNT][8];
+	};
+
+	static Table table;
+
+	static void update(const Tile&);
+	static void clear(TileID);
+	static void clearAll();
+
+	static bool has(TileID blockId, Flag flag) { return (table.flags[blockId] & flag) != 0; }
+	static bool isSolid(TileID blockId) { return has(blockId, SOLID); }
+	static bool isTicking(TileID blockId) { return has(blockId, TICKS); }
+	static bool isLiquid(TileID blockId) { return has(blockId, LIQUID); }
+	static bool blocksMotion(TileID blockId) { return has(blockId, BLOCKS_MOTION); }
+	static bool isReplaceable(TileID blockId) { return has(blockId, REPLACEABLE); }
+	static bool emitsLight(TileID blockId) { return has(blockId, EMITS_LIGHT); }
+	static int getLightBlock(TileID blockId) { return table.lightBlock[blockId]; }
+	static int getLightEmission(TileID blockId) { return table.lightEmission[blockId]; }
+	static float getTranslucency(TileID blockId) { return table.translucency[blockId]; }
+	static float getExplosionResistance(TileID blockId) { return table.explosionResistance[blockId]; }
+
+	/* 256-bit set of every ID carrying the flag, 8 words */
+	static const uint32_t* getBits(Flag);
+
+	/* Bit i of the result is set if ids[i] has the flag, count <= 32 */
+	static uint32_t gather(const TileID* ids, int count, Flag);
+	/* Copies the flag byte of each ID into out, for callers testing several flags per ID */
+	static void gatherFlags(const TileID* ids, int count, uint8_t* out);
+
+private:
+	static int _flagIndex(Flag);
+	static void _setBit(int, TileID, bool);
+};
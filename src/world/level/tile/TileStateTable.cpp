@@ -0,0 +1,125 @@
+#include "TileStateTable.h"
+
+#include <cstring>
+
+#include "Tile.h"
+#include "TileCapabilities.h"
+#include "TileTextureTable.h"
+
+std::shared_ptr<const TileStateTable::Snapshot> TileStateTable::current = std::make_shared<TileStateTable::Snapshot>();
+bool TileStateTable::optOut[256];
+
+uint16_t TileStateTable::_addShape(Snapshot& table, const AABB& box)
+{
+	if(box.isEmpty())
+	{
+		return NO_SHAPE;
+	}
+
+	/* a few dozen distinct boxes in total, slabs and carpets share theirs */
+	for(size_t i = 0; i < table.shapes.size(); i++)
+	{
+		const AABB& shape = table.shapes[i];
+		if(shape.min.x == box.min.x && shape.min.y == box.min.y && shape.min.z == box.min.z &&
+			shape.max.x == box.max.x && shape.max.y == box.max.y && shape.max.z == box.max.z)
+		{
+			return i;
+		}
+	}
+
+	table.shapes.push_back(box);
+	return table.shapes.size() - 1;
+}
+
+/* Thousands of lookups but only a few hundred distinct sets, most tiles repeat one on every face and data value */
+uint16_t TileStateTable::_addUV(Snapshot& table, std::map<UVKey, uint16_t>& known, const TextureUVCoordinateSet& uv)
+{
+	UVKey key = {uv._u0, uv._v0, uv._u1, uv._v1};
+	auto it = known.find(key);
+	if(it != known.end())
+	{
+		return it->second;
+	}
+
+	uint16_t index = table.uvs.size();
+	table.uvs.push_back(uv);
+	known[key] = index;
+	return index;
+}
+
+void TileStateTable::_buildState(Snapshot& table, std::map<UVKey, uint16_t>& known, Tile& tile, DataID data, bool positionDependent)
+{
+	State& state = table.states[tile.blockId][data];
+	AABB scratch;
+	state.shape = _addShape(table, tile.getShape(data, scratch, false));
+
+	for(int face = 0; face < 6; face++)
+	{
+		state.uv[face] = _addUV(table, known, tile.getTexture(face, data));
+	}
+
+	state.color = tile.getColor(data);
+	state.renderShape = (uint8_t) tile.getRenderShape();
+	state.renderLayer = (uint8_t) tile.getRenderLayer();
+	state.lightEmission = (uint8_t) Tile::lightEmission[tile.blockId];
+	state.lightBlock = (uint8_t) Tile::lightBlock[tile.blockId];
+	state.flags = REGISTERED;
+	if(tile.isAlphaTested())
+	{
+		state.flags |= ALPHA_TESTED;
+	}
+	if(positionDependent)
+	{
+		state.flags |= POSITION_DEPENDENT;
+	}
+}
+
+/* Builds the whole table off to the side, readers switch over on the store */
+void TileStateTable::build()
+{
+	std::shared_ptr<Snapshot> table = std::make_shared<Snapshot>();
+	memset(table->states, 0, sizeof(table->states));
+	std::map<UVKey, uint16_t> known;
+
+	for(int id = 0; id < 256; id++)
+	{
+		Tile* tile = Tile::tiles[id];
+		if(!tile)
+		{
+			continue;
+		}
+
+		uint32_t worldHooks = TileCapabilities::WORLD_SHAPE | TileCapabilities::WORLD_TEXTURE | TileCapabilities::WORLD_COLOR;
+		bool positionDependent = optOut[id] || (TileCapabilities::get(id) & worldHooks) != 0;
+		for(int data = 0; data < 16; data++)
+		{
+			_buildState(*table, known, *tile, data, positionDependent);
+		}
+	}
+
+	table->generation = TileTextureTable::getGeneration();
+	std::atomic_store_explicit(&current, std::shared_ptr<const Snapshot>(std::move(table)), std::memory_order_release);
+}
+
+void TileStateTable::clear()
+{
+	std::shared_ptr<Snapshot> table = std::make_shared<Snapshot>();
+	memset(table->states, 0, sizeof(table->states));
+	table->generation = 0;
+	std::atomic_store_explicit(&current, std::shared_ptr<const Snapshot>(std::move(table)), std::memory_order_release);
+	memset(optOut, 0, sizeof(optOut));
+}
+
+void TileStateTable::ensureCurrent()
+{
+	if(acquire()->generation != TileTextureTable::getGeneration())
+	{
+		build();
+	}
+}
+
+const AABB* TileStateTable::Snapshot::getShape(TileID blockId, DataID data) const
+{
+	uint16_t shape = get(blockId, data).shape;
+	return shape != NO_SHAPE? &shapes[shape] : NULL;
+}
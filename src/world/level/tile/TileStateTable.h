@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+class Tile;
+
+/* Everything the mesher and collision ask a (tile ID, data) pair, resolved once
+	Built after initTiles() and again when the atlas changes, from getShape(DataID),
+	getTexture(FacingID, int), getColor(int), getRenderShape(), getRenderLayer(),
+	isAlphaTested() and the light tables. Equal shapes and UV sets are stored once and
+	referenced by index.
+
+	A tile whose answers depend on where it is (it overrides one of the TileSource
+	overloads, see TileCapabilities::WORLD_*, or was marked with setPositionDependent)
+	keeps POSITION_DEPENDENT set and callers must ask the tile itself.
+
+	Like TileTextureTable, the table is an immutable snapshot behind a shared_ptr that
+	build() replaces with an atomic store, so meshing threads keep reading the old one
+	while the atlas is swapped. Anything that keeps references into the table (shapes,
+	UV sets) takes a Ref with acquire() and reads through it.
+*/
+class TileStateTable
+{
+public:
+	enum Flag : uint8_t
+	{
+		REGISTERED = 1 << 0,
+		ALPHA_TESTED = 1 << 1,
+		POSITION_DEPENDENT = 1 << 2
+	};
+
+	static const uint16_t NO_SHAPE = 0xFFFF;
+
+	struct State
+	{
+		uint16_t shape; // index into the shapes, NO_SHAPE for an empty box
+		uint16_t uv[6]; // per face, index into the UV sets
+		int color;
+		uint8_t renderShape;
+		uint8_t renderLayer;
+		uint8_t lightEmission;
+		uint8_t lightBlock;
+		uint8_t flags;
+	};
+
+	struct Snapshot
+	{
+		State states[256][16];
+		std::vector<AABB> shapes;
+		std::vector<TextureUVCoordinateSet> uvs;
+		uint32_t generation; // of the TileTextureTable it was built against
+
+		const State& get(TileID blockId, DataID data) const { return states[blockId][data & 15]; }
+		bool isPositionDependent(TileID blockId, DataID data) const { return (get(blockId, data).flags & POSITION_DEPENDENT) != 0; }
+		const AABB* getShape(TileID blockId, DataID data) const;
+		const TextureUVCoordinateSet& getUV(TileID blockId, DataID data, FacingID face) const { return uvs[get(blockId, data).uv[face]]; }
+		int getColor(TileID blockId, DataID data) const { return get(blockId, data).color; }
+	};
+
+	typedef std::shared_ptr<const Snapshot> Ref;
+
+	static void build();
+	static void clear();
+	static void ensureCurrent();
+
+	/* Explicit opt-out for tiles the override check can't see through, kept across builds */
+	static void setPositionDependent(TileID blockId, bool dependent = true) { optOut[blockId] = dependent; }
+
+	/* The current table, valid for as long as the caller holds it */
+	static Ref acquire() { return std::atomic_load_explicit(&current, std::memory_order_acquire); }
+
+	static State get(TileID blockId, DataID data) { return acquire()->get(blockId, data); }
+	static bool isPositionDependent(TileID blockId, DataID data) { return acquire()->isPositionDependent(blockId, data); }
+	static TextureUVCoordinateSet getUV(TileID blockId, DataID data, FacingID face) { return acquire()->getUV(blockId, data, face); }
+	static int getColor(TileID blockId, DataID data) { return acquire()->getColor(blockId, data); }
+
+private:
+	struct UVKey
+	{
+		float u0, v0, u1, v1;
+
+		bool operator<(const UVKey& other) const
+		{
+			return std::tie(u0, v0, u1, v1) < std::tie(other.u0, other.v0, other.u1, other.v1);
+		}
+	};
+
+	static std::shared_ptr<const Snapshot> current;
+	static bool optOut[256];
+
+	static uint16_t _addShape(Snapshot&, const AABB&);
+	static uint16_t _addUV(Snapshot&, std::map<UVKey, uint16_t>&, const TextureUVCoordinateSet&);
+	static void _buildState(Snapshot&, std::map<UVKey, uint16_t>&, Tile&, DataID, bool positionDependent);
+};
@@ -0,0 +1,66 @@
+#include "TileTextureTable.h"
+
+#include <cstring>
+
+std::shared_ptr<const TileTextureTable::Snapshot> TileTextureTable::current = std::make_shared<TileTextureTable::Snapshot>();
+std::vector<std::string> TileTextureTable::names;
+std::unordered_map<std::string, TileTextureTable::Handle> TileTextureTable::handles;
+TextureAtlas* TileTextureTable::atlas = NULL;
+TileTextureTable::Handle TileTextureTable::bindings[256];
+std::mutex TileTextureTable::mutex;
+
+/* The old table goes away with the last reader still holding it */
+void TileTextureTable::_publish(std::shared_ptr<Snapshot> snapshot)
+{
+	snapshot->generation = acquire()->generation + 1;
+	std::atomic_store_explicit(&current, std::shared_ptr<const Snapshot>(std::move(snapshot)), std::memory_order_release);
+}
+
+TileTextureTable::Handle TileTextureTable::resolve(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto it = handles.find(name);
+	if(it != handles.end())
+	{
+		return it->second;
+	}
+
+	Handle handle = names.size();
+	names.push_back(name);
+	handles[name] = handle;
+
+	/* tiles resolve their names during init, copy the table once per new name */
+	std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>(*acquire());
+	snapshot->items.push_back(&atlas->getTextureItem(name));
+	snapshot->first.push_back(snapshot->getItem(handle)[0]);
+	_publish(std::move(snapshot));
+	return handle;
+}
+
+void TileTextureTable::rebuild(TextureAtlas& _atlas)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	atlas = &_atlas;
+	std::shared_ptr<Snapshot> snapshot = std::make_shared<Snapshot>();
+	snapshot->items.reserve(names.size());
+	snapshot->first.reserve(names.size());
+	for(const std::string& name : names)
+	{
+		snapshot->items.push_back(&atlas->getTextureItem(name));
+		snapshot->first.push_back((*snapshot->items.back())[0]);
+	}
+
+	_publish(std::move(snapshot));
+}
+
+void TileTextureTable::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::atomic_store_explicit(&current, std::shared_ptr<const Snapshot>(std::make_shared<Snapshot>()), std::memory_order_release);
+	names.clear();
+	handles.clear();
+	memset(bindings, 0, sizeof(bindings));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Texture names resolved once to integer handles
+	A handle indexes a flat table holding the atlas item and its first UV set, so a
+	lookup is an atomic load and two array reads instead of a string hash into the
+	TextureAtlas. Tiles built from a texture name are bound to its handle, and
+	Tile::setTextureAtlas() uses the binding to move their texture to the new atlas.
+
+	The table is an immutable snapshot behind a shared_ptr. rebuild() and resolve() build
+	a new one and publish it with an atomic store; a reader keeps whatever it loaded alive
+	for as long as it holds the reference, and the mesher takes one with acquire() per
+	section instead of per lookup. That covers the table only: the Tile::texture fields
+	are rebound in place by Tile::setTextureAtlas(), which needs the readers stopped. Items point into the atlas, so getItem() references
+	live as long as the atlas does, as they did before the table.
+*/
+class TileTextureTable
+{
+public:
+	typedef uint16_t Handle;
+	static const Handle NONE = 0xFFFF;
+
+	struct Snapshot
+	{
+		std::vector<const TextureAtlasTextureItem*> items;
+		std::vector<TextureUVCoordinateSet> first;
+		uint32_t generation;
+
+		const TextureAtlasTextureItem& getItem(Handle handle) const { return *items[handle]; }
+		const TextureUVCoordinateSet& getUV(Handle handle) const { return first[handle]; }
+	};
+
+	typedef std::shared_ptr<const Snapshot> Ref;
+
+	/* Interns name, resolving it against the current atlas if it's new */
+	static Handle resolve(const std::string& name);
+	/* Re-resolves every name against atlas and swaps the table in */
+	static void rebuild(TextureAtlas& atlas);
+	static void clear();
+
+	/* The current table, valid for as long as the caller holds it */
+	static Ref acquire() { return std::atomic_load_explicit(&current, std::memory_order_acquire); }
+
+	static const TextureAtlasTextureItem& getItem(Handle handle) { return acquire()->getItem(handle); }
+	static TextureUVCoordinateSet getUV(Handle handle) { return acquire()->getUV(handle); }
+	static TextureUVCoordinateSet getUV(Handle handle, int index) { return acquire()->getItem(handle)[index]; }
+	static int getHandleCount() { return acquire()->items.size(); }
+	static uint32_t getGeneration() { return acquire()->generation; }
+
+	/* Tile IDs built from a texture name, NONE otherwise */
+	static void bind(TileID blockId, Handle handle) { bindings[blockId] = handle + 1; }
+	static void unbind(TileID blockId) { bindings[blockId] = 0; }
+	static Handle getBinding(TileID blockId) { return (Handle) (bindings[blockId] - 1); }
+
+private:
+	static std::shared_ptr<const Snapshot> current;
+	static std::vector<std::string> names;
+	static std::unordered_map<std::string, Handle> handles;
+	static TextureAtlas* atlas;
+	static Handle bindings[256]; // handle + 1, so the zeroed table reads as NONE
+	static std::mutex mutex;
+
+	static void _publish(std::shared_ptr<Snapshot>);
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+/* Frame arena for collision candidates
+	reset() only rewinds, storage grows to the high-water mark once and is then reused,
+	so a steady stream of entity moves never reallocates.
+*/
+class AABBArena
+{
+public:
+	AABBArena(size_t initialCapacity = 256)
+	{
+		storage.resize(initialCapacity);
+		count = 0;
+	}
+
+	void reset() { count = 0; }
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	size_t capacity() const { return storage.size(); }
+
+	const AABB* begin() const { return storage.data(); }
+	const AABB* end() const { return storage.data() + count; }
+	const AABB& operator[](size_t index) const { return storage[index]; }
+
+	void push(const AABB& aabb)
+	{
+		if(count == storage.size())
+		{
+			storage.resize(storage.size() * 2);
+		}
+		storage[count++] = aabb;
+	}
+
+private:
+	std::vector<AABB> storage;
+	size_t count;
+};
@@ -0,0 +1,203 @@
+#include "TileCollider.h"
+
+#include <cmath>
+
+#include "TileShapeCache.h"
+#include "world/level/tile/Tile.h"
+
+TileCollider::TileCollider()
+{
+	resetStats();
+}
+
+void TileCollider::resetStats()
+{
+	stats = Stats();
+}
+
+AABB TileCollider::_offset(const AABB& aabb, float x, float y, float z)
+{
+	return AABB(aabb.min.x + x, aabb.min.y + y, aabb.min.z + z, aabb.max.x + x, aabb.max.y + y, aabb.max.z + z);
+}
+
+/* Grows the box in the direction of the movement only */
+AABB TileCollider::_expand(const AABB& aabb, const Vec3& delta)
+{
+	AABB expanded(aabb);
+	(delta.x < 0.0F? expanded.min.x : expanded.max.x) += delta.x;
+	(delta.y < 0.0F? expanded.min.y : expanded.max.y) += delta.y;
+	(delta.z < 0.0F? expanded.min.z : expanded.max.z) += delta.z;
+	return expanded;
+}
+
+void TileCollider::gatherBoxes(TileSource& region, const AABB& area)
+{
+	boxes.reset();
+
+	int minX = (int) floorf(area.min.x);
+	int minY = (int) floorf(area.min.y) - 1; // fences and walls reach up into the box
+	int minZ = (int) floorf(area.min.z);
+	int maxX = (int) floorf(area.max.x + 1.0F);
+	int maxY = (int) floorf(area.max.y + 1.0F);
+	int maxZ = (int) floorf(area.max.z + 1.0F);
+
+	for(int x = minX; x < maxX; x++)
+	{
+		for(int z = minZ; z < maxZ; z++)
+		{
+			for(int y = minY; y < maxY; y++)
+			{
+				stats.tilesVisited++;
+				FullTile tile = region.getTileAndData({x, y, z});
+				const TileShapeCache::Entry& entry = TileShapeCache::get(tile.blockId, tile.data);
+
+				switch(entry.kind)
+				{
+				case TileShapeCache::EMPTY:
+					stats.emptySkipped++;
+					break;
+				case TileShapeCache::FULL:
+				case TileShapeCache::SHAPE:
+				{
+					if(entry.kind == TileShapeCache::FULL)
+					{
+						stats.fullCubes++;
+					}
+					else
+					{
+						stats.cachedShapes++;
+					}
+
+					const AABB* shapes = TileShapeCache::getShapes(entry);
+					for(int i = 0; i < entry.count; i++)
+					{
+						AABB box = _offset(shapes[i], (float) x, (float) y, (float) z);
+						if(area.intersects(box))
+						{
+							boxes.push(box);
+						}
+					}
+					break;
+				}
+				default:
+				{
+					stats.virtualCalls++;
+					scratch.clear();
+					Tile::tiles[tile.blockId]->addAABBs(&region, x, y, z, &area, scratch);
+					for(const AABB& box : scratch)
+					{
+						boxes.push(box);
+					}
+					break;
+				}
+				}
+			}
+		}
+	}
+}
+
+float TileCollider::clipX(const AABB& box, const AABB& other, float dx)
+{
+	if(other.max.y <= box.min.y || other.min.y >= box.max.y || other.max.z <= box.min.z || other.min.z >= box.max.z)
+	{
+		return dx;
+	}
+	if(dx > 0.0F && other.min.x >= box.max.x)
+	{
+		float max = other.min.x - box.max.x;
+		if(max < dx)
+		{
+			dx = max;
+		}
+	}
+	else if(dx < 0.0F && other.max.x <= box.min.x)
+	{
+		float max = other.max.x - box.min.x;
+		if(max > dx)
+		{
+			dx = max;
+		}
+	}
+
+	return dx;
+}
+
+float TileCollider::clipY(const AABB& box, const AABB& other, float dy)
+{
+	if(other.max.x <= box.min.x || other.min.x >= box.max.x || other.max.z <= box.min.z || other.min.z >= box.max.z)
+	{
+		return dy;
+	}
+	if(dy > 0.0F && other.min.y >= box.max.y)
+	{
+		float max = other.min.y - box.max.y;
+		if(max < dy)
+		{
+			dy = max;
+		}
+	}
+	else if(dy < 0.0F && other.max.y <= box.min.y)
+	{
+		float max = other.max.y - box.min.y;
+		if(max > dy)
+		{
+			dy = max;
+		}
+	}
+
+	return dy;
+}
+
+float TileCollider::clipZ(const AABB& box, const AABB& other, float dz)
+{
+	if(other.max.x <= box.min.x || other.min.x >= box.max.x || other.max.y <= box.min.y || other.min.y >= box.max.y)
+	{
+		return dz;
+	}
+	if(dz > 0.0F && other.min.z >= box.max.z)
+	{
+		float max = other.min.z - box.max.z;
+		if(max < dz)
+		{
+			dz = max;
+		}
+	}
+	else if(dz < 0.0F && other.max.z <= box.min.z)
+	{
+		float max = other.max.z - box.min.z;
+		if(max > dz)
+		{
+			dz = max;
+		}
+	}
+
+	return dz;
+}
+
+Vec3 TileCollider::move(TileSource& region, AABB& box, const Vec3& delta)
+{
+	gatherBoxes(region, _expand(box, delta));
+
+	float dy = delta.y;
+	for(const AABB& other : boxes)
+	{
+		dy = clipY(box, other, dy);
+	}
+	box = _offset(box, 0.0F, dy, 0.0F);
+
+	float dx = delta.x;
+	for(const AABB& other : boxes)
+	{
+		dx = clipX(box, other, dx);
+	}
+	box = _offset(box, dx, 0.0F, 0.0F);
+
+	float dz = delta.z;
+	for(const AABB& other : boxes)
+	{
+		dz = clipZ(box, other, dz);
+	}
+	box = _offset(box, 0.0F, 0.0F, dz);
+
+	return Vec3(dx, dy, dz);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+
+#include "AABBArena.h"
+
+/* Swept-AABB collision against tiles
+	Candidates in the broadphase box come from TileShapeCache: air and full cubes are
+	resolved from the ID alone, data-driven shapes are copied from the cache and only
+	DYNAMIC tiles go through the virtual Tile::addAABBs. Boxes land in a frame arena
+	that is rewound, never freed, between moves.
+*/
+class TileCollider
+{
+public:
+	struct Stats
+	{
+		int tilesVisited;
+		int emptySkipped;
+		int fullCubes;
+		int cachedShapes;
+		int virtualCalls;
+	};
+
+	TileCollider();
+
+	/* Collects every tile box intersecting area into the arena */
+	void gatherBoxes(TileSource&, const AABB&);
+	/* Moves box by delta, clipping Y then X then Z like Entity::move, returns the allowed delta */
+	Vec3 move(TileSource&, AABB&, const Vec3&);
+
+	const AABBArena& getBoxes() const { return boxes; }
+	const Stats& getStats() const { return stats; }
+	void resetStats();
+
+	static float clipX(const AABB& box, const AABB& other, float dx);
+	static float clipY(const AABB& box, const AABB& other, float dy);
+	static float clipZ(const AABB& box, const AABB& other, float dz);
+
+private:
+	AABBArena boxes;
+	std::vector<AABB> scratch;
+	Stats stats;
+
+	static AABB _offset(const AABB&, float, float, float);
+	static AABB _expand(const AABB&, const Vec3&);
+};
@@ -0,0 +1,254 @@
+#include "TileRaycaster.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "TileShapeCache.h"
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+
+TileRaycaster::TileRaycaster()
+{
+	cache.resize(CACHE_SIZE);
+	useCache = false;
+	resetStats();
+}
+
+void TileRaycaster::resetStats()
+{
+	stats = Stats();
+}
+
+void TileRaycaster::_clearCache()
+{
+	for(CachedTile& entry : cache)
+	{
+		entry.valid = false;
+	}
+}
+
+FullTile TileRaycaster::_getTile(TileSource& region, int x, int y, int z)
+{
+	if(!useCache)
+	{
+		return region.getTileAndData({x, y, z});
+	}
+
+	unsigned int hash = ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u) ^ ((unsigned int) z * 83492791u);
+	CachedTile& entry = cache[hash & (CACHE_SIZE - 1)];
+	if(entry.valid && entry.x == x && entry.y == y && entry.z == z)
+	{
+		stats.cacheHits++;
+		return entry.tile;
+	}
+
+	entry.x = x;
+	entry.y = y;
+	entry.z = z;
+	entry.tile = region.getTileAndData({x, y, z});
+	entry.valid = true;
+	return entry.tile;
+}
+
+/* Entry/exit along the three slabs at once, face is the slab the segment entered through */
+bool TileRaycaster::clipBox(const AABB& box, const Vec3& from, const Vec3& to, float& t, FacingID& face)
+{
+	float dir[3] = {to.x - from.x, to.y - from.y, to.z - from.z};
+	float inv[3];
+	for(int i = 0; i < 3; i++)
+	{
+		inv[i] = (dir[i] != 0.0F)? 1.0F / dir[i] : FLT_MAX;
+	}
+
+	const float start[3] = {from.x, from.y, from.z};
+	const float min[3] = {box.min.x, box.min.y, box.min.z};
+	const float max[3] = {box.max.x, box.max.y, box.max.z};
+
+	float nearT[3], farT[3];
+	for(int i = 0; i < 3; i++)
+	{
+		float t0 = (min[i] - start[i]) * inv[i];
+		float t1 = (max[i] - start[i]) * inv[i];
+		nearT[i] = std::min(t0, t1);
+		farT[i] = std::max(t0, t1);
+	}
+
+	/* a zero direction leaves the slab test to whether we start inside it */
+	for(int i = 0; i < 3; i++)
+	{
+		if(dir[i] == 0.0F)
+		{
+			if(start[i] < min[i] || start[i] > max[i])
+			{
+				return false;
+			}
+			nearT[i] = -FLT_MAX;
+			farT[i] = FLT_MAX;
+		}
+	}
+
+	int axis = 0;
+	float enter = nearT[0];
+	for(int i = 1; i < 3; i++)
+	{
+		if(nearT[i] > enter)
+		{
+			enter = nearT[i];
+			axis = i;
+		}
+	}
+	float exit = std::min(farT[0], std::min(farT[1], farT[2]));
+
+	if(enter > exit || exit < 0.0F || enter > 1.0F)
+	{
+		return false;
+	}
+
+	/* faces are 0 down, 1 up, 2 north, 3 south, 4 west, 5 east; index 0 is x */
+	static const FacingID NEGATIVE_FACE[3] = {4, 0, 2};
+	static const FacingID POSITIVE_FACE[3] = {5, 1, 3};
+	face = (dir[axis] > 0.0F)? NEGATIVE_FACE[axis] : POSITIVE_FACE[axis];
+	t = std::max(enter, 0.0F);
+	return true;
+}
+
+bool TileRaycaster::_testCell(TileSource& region, int x, int y, int z, const Vec3& from, const Vec3& to, float t, FacingID face, bool liquid, HitResult& hit)
+{
+	stats.cellsVisited++;
+	FullTile tile = _getTile(region, x, y, z);
+	if(!TileProperties::has(tile.blockId, TileProperties::REGISTERED))
+	{
+		return false;
+	}
+
+	const TileShapeCache::Entry& entry = TileShapeCache::get(tile.blockId, tile.data);
+	if(entry.kind == TileShapeCache::FULL && face <= 5)
+	{
+		hit = HitResult(x, y, z, face, Vec3(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, from.z + (to.z - from.z) * t));
+		return true;
+	}
+
+	Tile* type = Tile::tiles[tile.blockId];
+	if(!type->mayPick(tile.data, liquid))
+	{
+		return false;
+	}
+
+	stats.clipCalls++;
+	HitResult result = type->clip(&region, x, y, z, from, to, liquid, tile.data);
+	if(!result.isHit())
+	{
+		return false;
+	}
+
+	hit = result;
+	return true;
+}
+
+HitResult TileRaycaster::trace(TileSource& region, const Vec3& from, const Vec3& to, bool liquid)
+{
+	stats.rays++;
+
+	float dx = to.x - from.x, dy = to.y - from.y, dz = to.z - from.z;
+	int x = (int) floorf(from.x), y = (int) floorf(from.y), z = (int) floorf(from.z);
+	int endX = (int) floorf(to.x), endY = (int) floorf(to.y), endZ = (int) floorf(to.z);
+
+	int stepX = (dx > 0.0F)? 1 : (dx < 0.0F)? -1 : 0;
+	int stepY = (dy > 0.0F)? 1 : (dy < 0.0F)? -1 : 0;
+	int stepZ = (dz > 0.0F)? 1 : (dz < 0.0F)? -1 : 0;
+
+	/* t is the fraction of the segment, tMax the t at which the next boundary is crossed */
+	float tDeltaX = stepX? fabsf(1.0F / dx) : FLT_MAX;
+	float tDeltaY = stepY? fabsf(1.0F / dy) : FLT_MAX;
+	float tDeltaZ = stepZ? fabsf(1.0F / dz) : FLT_MAX;
+	float tMaxX = stepX? ((stepX > 0)? (x + 1.0F - from.x) : (from.x - x)) * tDeltaX : FLT_MAX;
+	float tMaxY = stepY? ((stepY > 0)? (y + 1.0F - from.y) : (from.y - y)) * tDeltaY : FLT_MAX;
+	float tMaxZ = stepZ? ((stepZ > 0)? (z + 1.0F - from.z) : (from.z - z)) * tDeltaZ : FLT_MAX;
+
+	HitResult hit;
+	/* the starting cell has no entry face, it always goes through clip */
+	if(_testCell(region, x, y, z, from, to, 0.0F, 6, liquid, hit))
+	{
+		return hit;
+	}
+
+	for(int steps = 0; steps < MAX_STEPS; steps++)
+	{
+		if(x == endX && y == endY && z == endZ)
+		{
+			break;
+		}
+
+		float t;
+		FacingID face;
+		if(tMaxX < tMaxY && tMaxX < tMaxZ)
+		{
+			t = tMaxX;
+			x += stepX;
+			tMaxX += tDeltaX;
+			face = (stepX > 0)? 4 : 5;
+		}
+		else if(tMaxY < tMaxZ)
+		{
+			t = tMaxY;
+			y += stepY;
+			tMaxY += tDeltaY;
+			face = (stepY > 0)? 0 : 1;
+		}
+		else
+		{
+			t = tMaxZ;
+			z += stepZ;
+			tMaxZ += tDeltaZ;
+			face = (stepZ > 0)? 2 : 3;
+		}
+
+		if(t > 1.0F)
+		{
+			break;
+		}
+		if(_testCell(region, x, y, z, from, to, t, face, liquid, hit))
+		{
+			return hit;
+		}
+	}
+
+	return HitResult();
+}
+
+/* Rays are walked grouped by the section they start in so neighbouring rays hit the cache */
+void TileRaycaster::traceBatch(TileSource& region, const Ray* rays, int count, HitResult* out, bool liquid)
+{
+	std::vector<int> order(count);
+	for(int i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [rays](int a, int b)
+	{
+		const Vec3& pa = rays[a].from;
+		const Vec3& pb = rays[b].from;
+		int sa[3] = {(int) floorf(pa.x) >> 4, (int) floorf(pa.y) >> 4, (int) floorf(pa.z) >> 4};
+		int sb[3] = {(int) floorf(pb.x) >> 4, (int) floorf(pb.y) >> 4, (int) floorf(pb.z) >> 4};
+		return std::lexicographical_compare(sa, sa + 3, sb, sb + 3);
+	});
+
+	_clearCache();
+	useCache = true;
+	for(int index : order)
+	{
+		out[index] = trace(region, rays[index].from, rays[index].to, liquid);
+	}
+	useCache = false;
+}
+
+void TileRaycaster::canSeeBatch(TileSource& region, const Ray* rays, int count, bool* out)
+{
+	std::vector<HitResult> hits(count);
+	traceBatch(region, rays, count, hits.data(), false);
+	for(int i = 0; i < count; i++)
+	{
+		out[i] = !hits[i].isHit();
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+/* Ray/tile intersection by Amanatides-Woo grid traversal
+	Each visited cell costs one ID lookup; air is skipped from the property table,
+	full cubes are hit on the face the ray entered through, and only other shapes
+	go through the virtual Tile::clip. traceBatch() shares tile lookups between rays
+	through a small position cache, which is what line-of-sight bursts want.
+*/
+class TileRaycaster
+{
+public:
+	struct Ray
+	{
+		Vec3 from;
+		Vec3 to;
+	};
+
+	struct Stats
+	{
+		int rays;
+		int cellsVisited;
+		int cacheHits;
+		int clipCalls;
+	};
+
+	TileRaycaster();
+
+	HitResult trace(TileSource&, const Vec3&, const Vec3&, bool liquid = false);
+	void traceBatch(TileSource&, const Ray*, int, HitResult*, bool liquid = false);
+	/* Line of sight only, stops at the first hit */
+	void canSeeBatch(TileSource&, const Ray*, int, bool*);
+
+	const Stats& getStats() const { return stats; }
+	void resetStats();
+
+	/* Slab test of the segment from -> to against box, t is the entry fraction along it */
+	static bool clipBox(const AABB&, const Vec3&, const Vec3&, float& t, FacingID& face);
+
+private:
+	static const int CACHE_SIZE = 4096;
+	static const int MAX_STEPS = 512;
+
+	struct CachedTile
+	{
+		int x, y, z;
+		FullTile tile;
+		bool valid;
+	};
+
+	std::vector<CachedTile> cache;
+	bool useCache;
+	Stats stats;
+
+	FullTile _getTile(TileSource&, int, int, int);
+	bool _testCell(TileSource&, int, int, int, const Vec3&, const Vec3&, float, FacingID, bool, HitResult&);
+	void _clearCache();
+};
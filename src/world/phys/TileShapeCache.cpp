@@ -0,0 +1,96 @@
+#include "TileShapeCache.h"
+#include "world/level/tile/Tile.h"
+#include "world/level/tile/TileProperties.h"
+#include "world/level/tile/TileCapabilities.h"
+#include "world/level/tile/TileStateTable.h"
+
+TileShapeCache::Entry TileShapeCache::entries[256][16];
+std::vector<AABB> TileShapeCache::shapes;
+
+static bool _isFullCube(const AABB& aabb)
+{
+	return aabb.min.x <= 0.0F && aabb.min.y <= 0.0F && aabb.min.z <= 0.0F &&
+		aabb.max.x >= 1.0F && aabb.max.y >= 1.0F && aabb.max.z >= 1.0F;
+}
+
+/* Decides how a state collides, shape receives the box for FULL and SHAPE */
+TileShapeCache::Kind TileShapeCache::_classify(Tile* tile, DataID data, AABB& shape)
+{
+	if(!tile || TileProperties::isLiquid(tile->blockId))
+	{
+		return EMPTY;
+	}
+
+	/* boxes built in getAABB or addAABBs (soul sand, fences, panes...) can't be derived from getShape */
+	uint32_t worldHooks = TileCapabilities::WORLD_AABB | TileCapabilities::ADD_AABBS | TileCapabilities::WORLD_SHAPE;
+	TileStateTable::Ref states = TileStateTable::acquire();
+	if((TileCapabilities::get(tile->blockId) & worldHooks) || states->isPositionDependent(tile->blockId, data))
+	{
+		return DYNAMIC;
+	}
+
+	const AABB* box = states->getShape(tile->blockId, data);
+
+	switch(tile->getTileType())
+	{
+	case TileType::Unspecified:
+		if(!TileProperties::isSolid(tile->blockId))
+		{
+			return DYNAMIC;
+		}
+		if(!box)
+		{
+			return DYNAMIC;
+		}
+		shape.set(*box);
+		return _isFullCube(shape)? FULL : DYNAMIC;
+	case TileType::HalfSlabTile:
+	case TileType::CarpetTile:
+		if(!box)
+		{
+			return EMPTY;
+		}
+		shape.set(*box);
+		return SHAPE;
+	default:
+		return DYNAMIC;
+	}
+}
+
+void TileShapeCache::build()
+{
+	shapes.clear();
+	for(int id = 0; id < 256; id++)
+	{
+		Tile* tile = Tile::tiles[id];
+		for(int data = 0; data < 16; data++)
+		{
+			Entry& entry = entries[id][data];
+			AABB shape;
+			entry.kind = _classify(tile, data, shape);
+			entry.count = 0;
+			entry.first = 0;
+
+			if(entry.kind == FULL || entry.kind == SHAPE)
+			{
+				entry.first = shapes.size();
+				entry.count = 1;
+				shapes.push_back(shape);
+			}
+		}
+	}
+}
+
+void TileShapeCache::clear()
+{
+	shapes.clear();
+	for(int id = 0; id < 256; id++)
+	{
+		for(int data = 0; data < 16; data++)
+		{
+			entries[id][data].kind = EMPTY;
+			entries[id][data].count = 0;
+			entries[id][data].first = 0;
+		}
+	}
+}
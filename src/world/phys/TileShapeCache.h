@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/* Collision shapes precomputed per (tile ID, data value)
+	Air, liquids and plain full cubes never reach a virtual call; simple data-driven
+	shapes are read from the flat list; everything that computes its boxes from the
+	world (stairs, fences, doors...) or declares its own getAABB or addAABBs in
+	TileCapabilities is marked DYNAMIC and still goes through addAABBs.
+*/
+class TileShapeCache
+{
+public:
+	enum Kind : uint8_t
+	{
+		EMPTY,
+		FULL,
+		SHAPE,
+		DYNAMIC
+	};
+
+	struct Entry
+	{
+		uint8_t kind;
+		uint8_t count;
+		uint16_t first;
+	};
+
+	/* Must run after Tile::initTiles() */
+	static void build();
+	static void clear();
+
+	static const Entry& get(TileID blockId, DataID data)
+	{
+		return entries[blockId][data & 15];
+	}
+
+	static const AABB* getShapes(const Entry& entry)
+	{
+		return shapes.data() + entry.first;
+	}
+
+private:
+	static Entry entries[256][16];
+	static std::vector<AABB> shapes;
+
+	static Kind _classify(Tile*, DataID, AABB&);
+};